@@ -1,5 +1,6 @@
 #define NPROC        64  // maximum number of processes
 #define KSTACKSIZE 4096  // size of per-process kernel stack
+#define NKSTACKCACHE 8   // CPU마다 재사용을 위해 보관하는 kernel stack 수
 #define NCPU          8  // maximum number of CPUs
 #define NOFILE       16  // open files per process
 #define NFILE       100  // open files per system
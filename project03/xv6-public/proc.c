@@ -94,7 +94,7 @@ found:
   release(&ptable.lock);
 
   // Allocate kernel stack.
-  if((p->kstack = kalloc()) == 0){
+  if((p->kstack = kstackalloc(p - ptable.proc)) == 0){
     p->state = UNUSED;
     return 0;
   }
@@ -204,7 +204,7 @@ fork(void)
 
   // Copy process state from proc.
   if((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0){
-    kfree(np->kstack);
+    kstackfree(np->kstack);
     np->kstack = 0;
     np->state = UNUSED;
     return -1;
@@ -299,6 +299,7 @@ wait(void)
 {
   struct proc *p;
   int havekids, pid;
+  pde_t *pgdir;
   struct proc *curproc = myproc();
   
   acquire(&ptable.lock);
@@ -312,15 +313,18 @@ wait(void)
       if(p->state == ZOMBIE){
         // Found one.
         pid = p->pid;
-        kfree(p->kstack);
+        kstackfree(p->kstack);
         p->kstack = 0;
-        freevm(p->pgdir);
+        pgdir = p->pgdir;
+        p->pgdir = 0;
         p->pid = 0;
         p->parent = 0;
         p->name[0] = 0;
         p->killed = 0;
         p->state = UNUSED;
         release(&ptable.lock);
+        // freevm은 TLB shootdown에서 다른 CPU를 기다릴 수 있으므로 ptable.lock을 놓은 후 호출
+        freevm(pgdir);
         return pid;
       }
     }
@@ -370,6 +374,7 @@ scheduler(void)
 
       swtch(&(c->scheduler), p->context);
       switchkvm();
+      c->pgdir = 0;  // kpgdir을 load했으므로 더 이상 user page table의 shootdown 대상이 아님
 
       // Process is done running for now.
       // It should have changed its p->state before coming back.
@@ -594,7 +599,7 @@ found:
   release(&ptable.lock);
 
   // Allocate kernel stack.
-  if((nt->kstack = kalloc()) == 0){
+  if((nt->kstack = kstackalloc(nt - ptable.proc)) == 0){
     nt->state = UNUSED;
     return -1; // kernel stack을 alloc하지 못한 경우 UNUSED로 돌리고 -1 리턴 (실패)
   }
@@ -742,7 +747,7 @@ thread_join(thread_t thread, void **retval)
       is_find = 1; // tid와 같은 thread를 찾은 경우
       if(p->state == ZOMBIE){
         // Found one.
-        kfree(p->kstack);
+        kstackfree(p->kstack);
         p->kstack = 0;
         // freevm(p->pgdir); thread는 각자 page table을 가지는게 아니라 복사하기 때문에 process와 달리 여기서 page table을 free해주면 안됨 
         // page table은 master_thread(=process)가 종료될 때, 기존에 process가 종료되는 루틴에 따라 wait() 콜에서 회수될 것임
@@ -782,7 +787,7 @@ kill_all_threads_without_curproc(struct proc *curproc)
     if(p->pid == curproc->pid && p != curproc){ 
       // curproc의 경우 exec()에서 실행할 대상이기 때문에 여기서 찾은 p가 curproc인 경우는 제외해줘야함
       // 만약 바로 아래에서처럼 실행할 대상의 kernel stack을 free하면 trap 오류가 발생
-      kfree(p->kstack);
+      kstackfree(p->kstack);
       p->kstack = 0;
       // freevm(p->pgdir); // thread는 각자 page table을 가지는게 아니라 복사하기 때문에 process와 달리 page table을 free해주면 안됨 
       // page table은 master_thread(=process)가 exit()될 때 기존 wait() 콜에서 회수될거임
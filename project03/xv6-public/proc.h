@@ -8,6 +8,8 @@ struct cpu {
   int ncli;                    // Depth of pushcli nesting.
   int intena;                  // Were interrupts enabled before pushcli?
   struct proc *proc;           // The process running on this cpu or null
+  pde_t *pgdir;                // 현재 load된 user page table (없으면 0), TLB shootdown 대상을 찾을 때 사용
+  volatile uint tlbreq;        // 처리하지 않은 TLB shootdown 요청이 있으면 1
 };
 
 extern struct cpu cpus[NCPU];
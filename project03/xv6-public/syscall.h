@@ -23,4 +23,5 @@
 
 #define SYS_thread_create 22
 #define SYS_thread_exit   23
-#define SYS_thread_join   24
\ No newline at end of file
+#define SYS_thread_join   24
+#define SYS_tlbstat       25
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "tlbstat.h"
 
 int
 sys_fork(void)
@@ -128,4 +129,15 @@ sys_thread_join(void)
   }
 
   return thread_join(thread, retval);
+}
+
+int
+sys_tlbstat(void)
+{
+  struct tlbstat *st;
+
+  if(argptr(0, (void*)&st, sizeof(*st)) < 0)
+    return -1;
+  gettlbstat(st);
+  return 0;
 }
\ No newline at end of file
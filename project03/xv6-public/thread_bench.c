@@ -0,0 +1,53 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NTHREAD  4
+#define ROUNDS   500
+
+// thread를 만들고 join하는 것을 반복하여 thread 생성/종료 비용을 측정
+// thread의 kernel stack은 CPU마다 보관된 stack을 재사용하므로, 처음 round 이후에는 kalloc/kfree를 거의 거치지 않음
+volatile int count;
+
+void *
+worker(void *arg)
+{
+  __sync_fetch_and_add(&count, 1);
+  thread_exit(arg);
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  thread_t thread[NTHREAD];
+  void *retval;
+  int start, elapsed;
+
+  printf(1, "[thread bench] %d rounds x %d threads\n", ROUNDS, NTHREAD);
+
+  start = uptime();
+  for(int r = 0; r < ROUNDS; r++){
+    for(int i = 0; i < NTHREAD; i++){
+      if(thread_create(&thread[i], worker, (void*)i) != 0){
+        printf(1, "thread_create failed\n");
+        exit();
+      }
+    }
+    for(int i = 0; i < NTHREAD; i++){
+      if(thread_join(thread[i], &retval) != 0 || (int)retval != i){
+        printf(1, "thread_join failed\n");
+        exit();
+      }
+    }
+  }
+  elapsed = uptime() - start;
+
+  if(count != ROUNDS * NTHREAD){
+    printf(1, "FAIL: %d threads ran, expected %d\n", count, ROUNDS * NTHREAD);
+    exit();
+  }
+  printf(1, "%d threads created and joined in %d ticks\n", count, elapsed);
+  printf(1, "OK\n");
+  exit();
+}
@@ -0,0 +1,86 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "tlbstat.h"
+
+#define PGSIZE   4096
+#define NTHREAD  4
+#define NPAGES   16    // 매 round마다 sbrk로 늘렸다가 줄이는 page 수
+#define ROUNDS   200
+
+// main thread가 region을 새로 할당하고 round 번호로 채운 후 round를 증가시키면,
+// 각 thread는 region의 모든 page가 round 번호인지 확인하고 done에 기록
+// region을 줄일 때 다른 CPU의 TLB가 무효화되지 않았다면, 다음 round에서 이전 physical page를 읽게 되어 실패함
+volatile int round;
+volatile int done[NTHREAD];
+char * volatile region;
+volatile int failed;
+thread_t thread[NTHREAD];
+
+void *
+reader(void *arg)
+{
+  int id = (int)arg;
+  int seen = 0;
+
+  while(seen < ROUNDS){
+    while(round == seen)
+      ;
+    seen = round;
+    for(int i = 0; i < NPAGES; i++){
+      if(region[i * PGSIZE] != (char)seen)
+        failed++;
+    }
+    done[id] = seen;
+  }
+  thread_exit(0);
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct tlbstat before, after;
+  void *retval;
+  int start, elapsed, n;
+
+  printf(1, "[TLB stress] %d threads, %d rounds\n", NTHREAD, ROUNDS);
+
+  for(int i = 0; i < NTHREAD; i++){
+    if(thread_create(&thread[i], reader, (void*)i) != 0){
+      printf(1, "thread_create failed\n");
+      exit();
+    }
+  }
+
+  tlbstat(&before);
+  start = uptime();
+  for(int r = 1; r <= ROUNDS; r++){
+    region = sbrk(NPAGES * PGSIZE);
+    for(int i = 0; i < NPAGES; i++)
+      region[i * PGSIZE] = (char)r;
+    round = r;
+    for(int i = 0; i < NTHREAD; i++)
+      while(done[i] != r)
+        ;
+    sbrk(-(NPAGES * PGSIZE)); // 다른 CPU에서 thread가 region을 TLB에 가지고 있으므로 shootdown 발생
+  }
+  elapsed = uptime() - start;
+  tlbstat(&after);
+
+  for(int i = 0; i < NTHREAD; i++)
+    thread_join(thread[i], &retval);
+
+  n = after.shootdowns - before.shootdowns;
+  printf(1, "%d ticks, shootdowns %d, IPIs %d\n", elapsed, n, after.ipis - before.ipis);
+  if(n > 0)
+    printf(1, "shootdown latency: avg %d cycles, max %d cycles\n",
+           (after.cycles - before.cycles) / n, after.maxcycles);
+
+  if(failed)
+    printf(1, "[TLB stress] fail (%d stale reads)\n", failed);
+  else
+    printf(1, "[TLB stress] pass\n");
+
+  exit();
+}
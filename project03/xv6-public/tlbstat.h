@@ -0,0 +1,7 @@
+// tlbstat system call이 반환하는 TLB shootdown 통계
+struct tlbstat {
+  uint shootdowns;  // 다른 CPU에 IPI를 보낸 shootdown 횟수
+  uint ipis;        // 보낸 IPI 수
+  uint cycles;      // shootdown에 걸린 cycle 수의 합 (32bit에서 wrap되므로 두 값의 차이로 사용)
+  uint maxcycles;   // 가장 오래 걸린 shootdown의 cycle 수
+};
@@ -1,5 +1,6 @@
 struct stat;
 struct rtcdate;
+struct tlbstat;
 
 // system calls
 int fork(void);
@@ -27,6 +28,7 @@ int uptime(void);
 int thread_create(thread_t *thread, void *(*start_routine)(void *), void *arg);
 void thread_exit(void *retval);
 int thread_join(thread_t thread, void **retval);
+int tlbstat(struct tlbstat*);
 
 // ulib.c
 int stat(const char*, struct stat*);
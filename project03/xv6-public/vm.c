@@ -6,10 +6,24 @@
 #include "mmu.h"
 #include "proc.h"
 #include "elf.h"
+#include "traps.h"
+#include "tlbstat.h"
 
 extern char data[];  // defined by kernel.ld
 pde_t *kpgdir;  // for use in scheduler()
 
+// kernel stack은 KSTACKBASE부터 ptable의 slot마다 2 page씩 배정된 가상 주소에 mapping
+// 각 slot의 아래쪽 page는 mapping하지 않는 guard page이므로, stack overflow가 다른 메모리를 덮어쓰지 않고 page fault를 발생시킴
+// KSTACKBASE 영역의 page table(kstackpgtab)은 하나만 만들어 모든 page directory가 공유
+static pte_t *kstackpgtab;
+
+// CPU마다 free된 kernel stack의 physical page를 보관하여, 다음 process/thread 생성 시 kalloc 없이 재사용
+// 자신의 CPU에서만 접근하고 pushcli 상태에서만 사용하므로 lock이 필요 X
+struct {
+  char *stack[NKSTACKCACHE];
+  int n;
+} kstackcache[NCPU];
+
 // Set up CPU's kernel segment descriptors.
 // Run once on entry on each CPU.
 void
@@ -79,6 +93,138 @@ mappages(pde_t *pgdir, void *va, uint size, uint pa, int perm)
   return 0;
 }
 
+// page table entry를 변경한 user 주소를 모아두었다가 한 번에 TLB에서 무효화
+// 모아둔 주소가 TLBBATCH개보다 많으면 주소마다 invlpg를 하는 것보다 CR3를 다시 load하는 것이 빠름
+#define TLBBATCH 32
+
+struct tlbbatch {
+  int n;
+  uint va[TLBBATCH];
+};
+
+// thread들은 같은 pgdir을 공유하면서 여러 CPU에서 동시에 실행될 수 있으므로,
+// PTE를 변경하면 그 pgdir을 load하고 있는 다른 CPU의 TLB도 IPI를 보내 무효화해야 함
+// 한 번에 하나의 shootdown만 진행
+struct {
+  volatile uint locked;
+  int n;                 // 무효화할 주소 수 (TLBBATCH보다 크면 TLB 전체 flush)
+  uint va[TLBBATCH];
+  volatile uint pending; // 아직 무효화를 끝내지 않은 CPU 수
+  struct tlbstat stat;
+} shootdown;
+
+static void
+tlb_add(struct tlbbatch *b, uint va)
+{
+  if(b->n < TLBBATCH)
+    b->va[b->n] = va;
+  b->n++;
+}
+
+// 현재 CPU의 TLB에서 n개의 주소를 무효화
+static void
+tlb_flushlocal(int n, uint *va)
+{
+  int i;
+
+  if(n > TLBBATCH)
+    lcr3(rcr3());
+  else
+    for(i = 0; i < n; i++)
+      invlpg((void*)va[i]);
+}
+
+// 현재 CPU에 shootdown 요청이 있으면 처리
+// interrupt가 꺼진 상태에서 호출되어야 함
+static void
+tlb_ack(struct cpu *c)
+{
+  if(!c->tlbreq)
+    return;
+  c->tlbreq = 0;
+  tlb_flushlocal(shootdown.n, shootdown.va);
+  xadd(&shootdown.pending, -1);
+}
+
+// TLB shootdown IPI handler
+void
+tlbintr(void)
+{
+  tlb_ack(mycpu());
+}
+
+// pgdir의 PTE를 변경한 후 호출하여 b에 모아둔 주소를 pgdir을 사용 중인 모든 CPU의 TLB에서 무효화
+// 다른 CPU의 응답을 기다리므로 spinlock을 잡은 상태에서 호출하면 안됨
+static void
+tlb_shootdown(pde_t *pgdir, struct tlbbatch *b)
+{
+  struct cpu *me, *c;
+  unsigned long long start, cycles;
+  int nipi = 0;
+
+  if(b->n == 0)
+    return;
+
+  pushcli();
+  me = mycpu();
+
+  // pgdir을 load한 다른 CPU가 없으면 shootdown.locked를 기다리지 않고 이 CPU만 무효화
+  // (wait의 freevm처럼 다른 CPU에서 실행될 수 없는 page table은 여기서 끝남)
+  // 이후 pgdir을 load하는 CPU는 lcr3로 TLB가 비워지므로, PTE 변경이 먼저 보이도록 barrier만 둠
+  __sync_synchronize();
+  for(c = cpus; c < cpus+ncpu; c++)
+    if(c != me && c->pgdir == pgdir)
+      break;
+  if(c == cpus+ncpu){
+    if(me->pgdir == pgdir)
+      tlb_flushlocal(b->n, b->va);
+    b->n = 0;
+    popcli();
+    return;
+  }
+
+  // 다른 CPU가 shootdown 중이라면 이 CPU의 응답을 기다리고 있을 수 있으므로, 요청을 처리하면서 기다림
+  // (xchg가 memory barrier 역할도 하므로 아래에서 c->pgdir을 읽기 전에 PTE 변경이 다른 CPU에 보임)
+  while(xchg(&shootdown.locked, 1) != 0)
+    tlb_ack(me);
+
+  start = rdtsc();
+  shootdown.n = b->n;
+  memmove(shootdown.va, b->va, sizeof(b->va));
+  shootdown.pending = 0;
+  for(c = cpus; c < cpus+ncpu; c++){
+    if(c == me || c->pgdir != pgdir)
+      continue;
+    xadd(&shootdown.pending, 1);
+    c->tlbreq = 1;
+    lapicipi(c->apicid, T_TLBFLUSH);
+    nipi++;
+  }
+  while(shootdown.pending != 0)
+    ;
+
+  if(nipi > 0){
+    cycles = rdtsc() - start;
+    shootdown.stat.shootdowns++;
+    shootdown.stat.ipis += nipi;
+    shootdown.stat.cycles += cycles;
+    if(cycles > shootdown.stat.maxcycles)
+      shootdown.stat.maxcycles = cycles;
+  }
+  xchg(&shootdown.locked, 0);
+
+  if(me->pgdir == pgdir)
+    tlb_flushlocal(b->n, b->va);
+  b->n = 0;
+  popcli();
+}
+
+void
+gettlbstat(struct tlbstat *st)
+{
+  *st = shootdown.stat;
+}
+
 // There is one page table per process, plus one that's used when
 // a CPU is not running any process (kpgdir). The kernel uses the
 // current process's page table during system calls and interrupts;
@@ -124,8 +270,14 @@ setupkvm(void)
   if((pgdir = (pde_t*)kalloc()) == 0)
     return 0;
   memset(pgdir, 0, PGSIZE);
-  if (P2V(PHYSTOP) > (void*)DEVSPACE)
+  if (P2V(PHYSTOP) > (void*)KSTACKBASE)
     panic("PHYSTOP too high");
+  if(kstackpgtab == 0){ // kvmalloc에서 처음 호출될 때 만듦
+    if((kstackpgtab = (pte_t*)kalloc()) == 0)
+      panic("setupkvm: kstackpgtab");
+    memset(kstackpgtab, 0, PGSIZE);
+  }
+  pgdir[PDX(KSTACKBASE)] = V2P(kstackpgtab) | PTE_P | PTE_W;
   for(k = kmap; k < &kmap[NELEM(kmap)]; k++)
     if(mappages(pgdir, k->virt, k->phys_end - k->phys_start,
                 (uint)k->phys_start, k->perm) < 0) {
@@ -144,6 +296,50 @@ kvmalloc(void)
   switchkvm();
 }
 
+// ptable의 slot번째 process/thread가 사용할 kernel stack을 할당하고 가상 주소를 반환, 실패하면 0을 반환
+// 이 CPU에 보관된 stack이 있으면 kalloc 없이 재사용
+char*
+kstackalloc(int slot)
+{
+  char *va = (char*)KSTACKBASE + (2*slot + 1)*PGSIZE, *mem = 0;
+
+  pushcli();
+  if(kstackcache[cpuid()].n > 0)
+    mem = kstackcache[cpuid()].stack[--kstackcache[cpuid()].n];
+  popcli();
+  if(mem == 0 && (mem = kalloc()) == 0)
+    return 0;
+  kstackpgtab[PTX(va)] = V2P(mem) | PTE_P | PTE_W;
+  // 이 CPU가 lcr3 없이 예전에 같은 slot의 stack에 접근했다면(예: thread를 만들면서 trapframe과 context를 씀)
+  // 다른 CPU가 kstackfree한 뒤에도 이전 page의 TLB entry가 남아있을 수 있으므로 무효화
+  invlpg(va);
+  return va;
+}
+
+// kstackalloc으로 할당한 kernel stack의 mapping을 지우고 physical page를 이 CPU에 보관
+// 현재 CPU의 TLB entry는 여기서 무효화하고, 다른 CPU에 남아있을 수 있는 entry는
+// 그 CPU가 새 process로 switchuvm할 때의 lcr3나 kstackalloc의 invlpg로 stack에 접근하기 전에 무효화됨
+void
+kstackfree(char *va)
+{
+  pte_t *pte = &kstackpgtab[PTX(va)];
+  char *mem = P2V(PTE_ADDR(*pte));
+
+  if(((uint)va - KSTACKBASE) / PGSIZE % 2 != 1 || !(*pte & PTE_P))
+    panic("kstackfree");
+  *pte = 0;
+  invlpg(va);
+
+  pushcli();
+  if(kstackcache[cpuid()].n < NKSTACKCACHE){
+    kstackcache[cpuid()].stack[kstackcache[cpuid()].n++] = mem;
+    mem = 0;
+  }
+  popcli();
+  if(mem)
+    kfree(mem);
+}
+
 // Switch h/w page table register to the kernel-only page table,
 // for when no process is running.
 void
@@ -173,6 +369,7 @@ switchuvm(struct proc *p)
   // forbids I/O instructions (e.g., inb and outb) from user space
   mycpu()->ts.iomb = (ushort) 0xFFFF;
   ltr(SEG_TSS << 3);
+  mycpu()->pgdir = p->pgdir;  // CR3를 바꾸기 전에 기록해야 이후의 shootdown 대상에서 빠지지 않음
   lcr3(V2P(p->pgdir));  // switch to process's address space
   popcli();
 }
@@ -257,10 +454,14 @@ deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 {
   pte_t *pte;
   uint a, pa;
+  struct tlbbatch tlb;
+  char *freepg[TLBBATCH];  // 다른 CPU의 TLB에서 무효화된 후에 free할 page들
+  int i, n;
 
   if(newsz >= oldsz)
     return oldsz;
 
+  tlb.n = 0;
   a = PGROUNDUP(newsz);
   for(; a  < oldsz; a += PGSIZE){
     pte = walkpgdir(pgdir, (char*)a, 0);
@@ -270,11 +471,22 @@ deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
       pa = PTE_ADDR(*pte);
       if(pa == 0)
         panic("kfree");
-      char *v = P2V(pa);
-      kfree(v);
+      // 다른 CPU에서 실행 중인 thread가 아직 이 page를 TLB에 가지고 있을 수 있으므로,
+      // shootdown이 끝난 후에 free
+      freepg[tlb.n] = P2V(pa);
       *pte = 0;
+      tlb_add(&tlb, a);
+      if(tlb.n == TLBBATCH){
+        tlb_shootdown(pgdir, &tlb);
+        for(i = 0; i < TLBBATCH; i++)
+          kfree(freepg[i]);
+      }
     }
   }
+  n = tlb.n;
+  tlb_shootdown(pgdir, &tlb);
+  for(i = 0; i < n; i++)
+    kfree(freepg[i]);
   return newsz;
 }
 
@@ -289,7 +501,7 @@ freevm(pde_t *pgdir)
     panic("freevm: no pgdir");
   deallocuvm(pgdir, KERNBASE, 0);
   for(i = 0; i < NPDENTRIES; i++){
-    if(pgdir[i] & PTE_P){
+    if((pgdir[i] & PTE_P) && i != PDX(KSTACKBASE)){ // 공유하는 kernel stack page table은 free하지 않음
       char * v = P2V(PTE_ADDR(pgdir[i]));
       kfree(v);
     }
@@ -130,6 +130,17 @@ xchg(volatile uint *addr, uint newval)
   return result;
 }
 
+// Atomically add incr to *addr and return the old value.
+static inline uint
+xadd(volatile uint *addr, uint incr)
+{
+  asm volatile("lock; xaddl %0, %1" :
+               "+r" (incr), "+m" (*addr) :
+               :
+               "memory", "cc");
+  return incr;
+}
+
 static inline uint
 rcr2(void)
 {
@@ -144,6 +155,31 @@ lcr3(uint val)
   asm volatile("movl %0,%%cr3" : : "r" (val));
 }
 
+static inline uint
+rcr3(void)
+{
+  uint val;
+  asm volatile("movl %%cr3,%0" : "=r" (val));
+  return val;
+}
+
+// Invalidate the TLB entry for the page containing addr.
+static inline void
+invlpg(void *addr)
+{
+  asm volatile("invlpg (%0)" : : "r" (addr) : "memory");
+}
+
+// Time Stamp Counter를 읽음
+static inline unsigned long long
+rdtsc(void)
+{
+  uint lo, hi;
+
+  asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((unsigned long long)hi << 32) | lo;
+}
+
 //PAGEBREAK: 36
 // Layout of the trap frame built on the stack by the
 // hardware and by trapasm.S, and passed to trap().
@@ -0,0 +1,68 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+
+#define NFILE   64     // block 하나 크기의 file 수
+#define N       4000   // 임의로 골라 읽는 횟수
+#define BSIZE   512
+
+// 같은 directory에 있는 file들을 임의의 순서로 열어 읽음
+// 모든 block이 buffer cache에 들어가므로, 측정 시간은 대부분 directory, inode, data block을 cache에서 찾는 비용
+unsigned long randstate = 1;
+
+unsigned int
+rand(void)
+{
+  randstate = randstate * 1664525 + 1013904223;
+  return randstate;
+}
+
+void
+name(char *path, int i)
+{
+  strcpy(path, "bb/f00");
+  path[4] = '0' + i / 10;
+  path[5] = '0' + i % 10;
+}
+
+int
+main(int argc, char *argv[])
+{
+  char path[16], buf[BSIZE];
+  int fd, start, elapsed;
+
+  printf(1, "[bcache bench] %d random reads over %d files\n", N, NFILE);
+
+  mkdir("bb");
+  memset(buf, 'a', sizeof(buf));
+  for(int i = 0; i < NFILE; i++){
+    name(path, i);
+    if((fd = open(path, O_CREATE | O_RDWR)) < 0){
+      printf(1, "create %s failed\n", path);
+      exit();
+    }
+    write(fd, buf, sizeof(buf));
+    close(fd);
+  }
+
+  start = uptime();
+  for(int i = 0; i < N; i++){
+    name(path, rand() % NFILE);
+    if((fd = open(path, O_RDONLY)) < 0 || read(fd, buf, sizeof(buf)) != sizeof(buf)){
+      printf(1, "read %s failed\n", path);
+      exit();
+    }
+    close(fd);
+  }
+  elapsed = uptime() - start;
+  printf(1, "random read: %d ticks\n", elapsed);
+
+  for(int i = 0; i < NFILE; i++){
+    name(path, i);
+    unlink(path);
+  }
+  unlink("bb");
+  printf(1, "OK\n");
+  exit();
+}
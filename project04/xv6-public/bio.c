@@ -1,6 +1,6 @@
 // Buffer cache.
 //
-// The buffer cache is a linked list of buf structures holding
+// The buffer cache is a hash table of buf structures holding
 // cached copies of disk block contents.  Caching disk blocks
 // in memory reduces the number of disk reads and also provides
 // a synchronization point for disk blocks used by multiple processes.
@@ -17,6 +17,13 @@
 // * B_VALID: the buffer data has been read from the disk.
 // * B_DIRTY: the buffer data has been modified
 //     and needs to be written to disk.
+//
+// buffer는 slab allocator로 필요할 때 만들며, free page가 충분하면 physical memory의 BCACHEPCT%까지 늘어남
+// free page가 부족하면 buffer를 새로 만들지 않고 재사용하고, swapd와 kalloc_user가 bshrink로 사용하지 않는 buffer를 돌려받음
+// buffer는 (dev, blockno)의 hash bucket에 연결되며, bucket마다 lock이 있어 서로 다른 block은 동시에 찾을 수 있음
+// 아무도 사용하지 않는(refcnt == 0) buffer는 LRU list에도 연결되어, cache에 없는 block을 읽을 때 LRU list의 끝에서 재사용
+// buffer가 담는 block을 바꾸는 일은 bcache.lock으로 한 번에 하나씩만 처리하므로,
+// bucket lock을 2개 잡는 것은 bcache.lock을 잡은 process뿐 (lock 순서: bcache.lock -> bucket lock -> lrulock)
 
 #include "types.h"
 #include "defs.h"
@@ -25,71 +32,240 @@
 #include "sleeplock.h"
 #include "fs.h"
 #include "buf.h"
+#include "x86.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "memstat.h"
+
+#define NBUCKET   1021
+#define BGROWFREE 1024  // free page가 이보다 많을 때만 buffer를 새로 만듦 (swapd의 SWAPHIGH와 같음)
+#define BUFPERPG  (PGSIZE / sizeof(struct buf))  // slab page 하나에 들어가는 buffer 수 (대략)
+
+struct bucket {
+  struct spinlock lock;  // 이 bucket에 연결된 buffer의 hnext, dev, blockno, refcnt를 보호
+  struct buf *head;
+};
 
 struct {
-  struct spinlock lock;
-  struct buf buf[NBUF];
+  struct spinlock lock;     // buffer를 만들거나 free하고, buffer가 담는 block을 바꾸는 것(재사용)을 직렬화
+  struct spinlock lrulock;  // LRU list(prev/next)를 보호
+  struct slabcache *cache;  // buffer를 할당하는 slab cache
+  uint nbuf;                // 현재 buffer 수
+  uint maxbuf;              // 최대 buffer 수
+  uint hit;                 // bget에서 cache에 있던 block 수
+  uint miss;                // bget에서 disk에서 읽어야 했던 block 수
+  uint ahead;               // breadahead로 미리 읽기 시작한 block 수
 
-  // Linked list of all buffers, through prev/next.
+  // Linked list of unused buffers (refcnt == 0), through prev/next.
   // head.next is most recently used.
   struct buf head;
+  struct bucket bucket[NBUCKET];
 } bcache;
 
+static void
+bufctor(void *obj)
+{
+  initsleeplock(&((struct buf*)obj)->lock, "buffer");
+}
+
+// slab allocator 초기화(slabinit) 후에 호출
 void
 binit(void)
 {
-  struct buf *b;
+  int i;
 
   initlock(&bcache.lock, "bcache");
+  initlock(&bcache.lrulock, "bcache.lru");
+  for(i = 0; i < NBUCKET; i++)
+    initlock(&bcache.bucket[i].lock, "bcache.bucket");
+  bcache.cache = slab_create("buf", sizeof(struct buf), bufctor);
+  bcache.maxbuf = PHYSTOP / PGSIZE * BCACHEPCT / 100 * (PGSIZE / sizeof(struct buf));
 
 //PAGEBREAK!
   // Create linked list of buffers
   bcache.head.prev = &bcache.head;
   bcache.head.next = &bcache.head;
-  for(b = bcache.buf; b < bcache.buf+NBUF; b++){
-    b->next = bcache.head.next;
-    b->prev = &bcache.head;
-    initsleeplock(&b->lock, "buffer");
-    bcache.head.next->prev = b;
-    bcache.head.next = b;
+}
+
+// 새로운 buffer를 만듦, memory가 없으면 0을 반환 (bcache.lock을 잡은 상태에서 호출)
+static struct buf*
+bufalloc(void)
+{
+  struct buf *b;
+
+  if((b = slab_alloc(bcache.cache)) == 0)
+    return 0;
+  bcache.nbuf++;
+  return b;
+}
+
+static struct bucket*
+bucketof(uint dev, uint blockno)
+{
+  return &bcache.bucket[(blockno ^ (dev << 16)) % NBUCKET];
+}
+
+// bk에서 (dev, blockno)를 담은 buffer를 찾음 (bk->lock을 잡은 상태에서 호출)
+static struct buf*
+lookup(struct bucket *bk, uint dev, uint blockno)
+{
+  struct buf *b;
+
+  for(b = bk->head; b != 0; b = b->hnext)
+    if(b->dev == dev && b->blockno == blockno)
+      return b;
+  return 0;
+}
+
+// LRU list에서 b를 뺌 (bcache.lrulock을 잡은 상태에서 호출)
+static void
+lru_remove(struct buf *b)
+{
+  b->next->prev = b->prev;
+  b->prev->next = b->next;
+}
+
+// b의 참조를 하나 늘리고, 사용하지 않던 buffer였으면 LRU list에서 뺌 (b의 bucket lock을 잡은 상태에서 호출)
+static void
+hold(struct buf *b)
+{
+  if(b->refcnt++ == 0){
+    acquire(&bcache.lrulock);
+    lru_remove(b);
+    release(&bcache.lrulock);
+  }
+}
+
+// LRU list의 끝부터 재사용할 수 있는 buffer를 찾아 LRU list와 hash bucket에서 빼고 반환, 없으면 0을 반환
+// bk는 호출한 쪽에서 이미 잡고 있는 bucket (없으면 0) (bcache.lock을 잡은 상태에서 호출)
+static struct buf*
+victim(struct bucket *bk)
+{
+  struct buf *b, **pp;
+  struct bucket *vk;
+
+  for(;;){
+    // Even if refcnt==0, B_DIRTY indicates a buffer is in use
+    // because log.c has modified it but not yet committed it.
+    acquire(&bcache.lrulock);
+    for(b = bcache.head.prev; b != &bcache.head && (b->flags & B_DIRTY); b = b->prev)
+      ;
+    release(&bcache.lrulock);
+    if(b == &bcache.head)
+      return 0;
+
+    // lrulock을 놓은 사이에 다른 process가 cache에서 찾아 사용하기 시작했을 수 있으므로 bucket lock을 잡고 다시 확인
+    // (buffer가 담는 block은 bcache.lock을 잡은 process만 바꾸므로 b의 bucket은 바뀌지 않음)
+    vk = bucketof(b->dev, b->blockno);
+    if(vk != bk)
+      acquire(&vk->lock);
+    if(b->refcnt == 0 && (b->flags & B_DIRTY) == 0)
+      break;
+    if(vk != bk)
+      release(&vk->lock);
+  }
+
+  acquire(&bcache.lrulock);
+  lru_remove(b);
+  release(&bcache.lrulock);
+  for(pp = &vk->head; *pp != b; pp = &(*pp)->hnext)
+    ;
+  *pp = b->hnext;
+  if(vk != bk)
+    release(&vk->lock);
+  return b;
+}
+
+// memory가 부족할 때 swapd, kalloc_user에서 호출
+// 사용하지 않는 buffer를 LRU 순서로 free하여 최대 npages개의 page를 돌려받고, 실제로 늘어난 free page 수를 반환 (NBUF개는 남겨둠)
+// buffer는 slab page 하나에 여러 개가 들어 있어 page의 모든 buffer가 free되어야 page가 돌아오므로,
+// free page 수로 진행 상황을 확인하고, 흩어진 buffer만 free하다가 cache를 모두 비우지 않도록 free할 buffer 수를 제한
+int
+bshrink(int npages)
+{
+  struct buf *b;
+  int i, start = countfp(), n;
+
+  acquire(&bcache.lock);
+  for(i = 0; i < npages * BUFPERPG * 2 && bcache.nbuf > NBUF; i++){
+    if((b = victim(0)) == 0)
+      break;
+    slab_free(bcache.cache, b);
+    bcache.nbuf--;
+    if(i % BUFPERPG == BUFPERPG - 1){ // magazine에 있는 buffer를 slab으로 돌려놓아 빈 page를 돌려받음
+      slab_reclaim(bcache.cache);
+      if(countfp() - start >= npages)
+        break;
+    }
   }
+  slab_reclaim(bcache.cache);
+  release(&bcache.lock);
+  n = countfp() - start;
+  return n > 0 ? n : 0;
 }
 
 // Look through buffer cache for block on device dev.
 // If not found, allocate a buffer.
 // In either case, return locked buffer.
+// ahead가 0이 아니면(readahead) block이 이미 cache에 있거나 재사용할 buffer가 없을 때 기다리지 않고 0을 반환
 static struct buf*
-bget(uint dev, uint blockno)
+bget(uint dev, uint blockno, int ahead)
 {
+  struct bucket *bk = bucketof(dev, blockno);
   struct buf *b;
 
-  acquire(&bcache.lock);
-
   // Is the block already cached?
-  for(b = bcache.head.next; b != &bcache.head; b = b->next){
-    if(b->dev == dev && b->blockno == blockno){
-      b->refcnt++;
-      release(&bcache.lock);
-      acquiresleep(&b->lock);
-      return b;
+  acquire(&bk->lock);
+  if((b = lookup(bk, dev, blockno)) != 0){
+    if(ahead){
+      release(&bk->lock);
+      return 0;
     }
+    hold(b);
+    release(&bk->lock);
+    xadd(&bcache.hit, 1);
+    acquiresleep(&b->lock);
+    return b;
   }
+  release(&bk->lock);
 
   // Not cached; recycle an unused buffer.
-  // Even if refcnt==0, B_DIRTY indicates a buffer is in use
-  // because log.c has modified it but not yet committed it.
-  for(b = bcache.head.prev; b != &bcache.head; b = b->prev){
-    if(b->refcnt == 0 && (b->flags & B_DIRTY) == 0) {
-      b->dev = dev;
-      b->blockno = blockno;
-      b->flags = 0;
-      b->refcnt = 1;
+  // bucket lock을 놓은 사이에 다른 process가 같은 block을 읽어왔을 수 있으므로 다시 확인
+  acquire(&bcache.lock);
+  acquire(&bk->lock);
+  if((b = lookup(bk, dev, blockno)) != 0){
+    if(ahead){
+      release(&bk->lock);
       release(&bcache.lock);
-      acquiresleep(&b->lock);
-      return b;
+      return 0;
+    }
+    hold(b);
+    xadd(&bcache.hit, 1);
+  } else {
+    // free page가 충분하면 buffer를 늘리고, 아니면 가장 오래전에 사용한 buffer를 재사용
+    b = 0;
+    if(bcache.nbuf < bcache.maxbuf && countfp() > BGROWFREE)
+      b = bufalloc();
+    if(b == 0 && (b = victim(bk)) == 0 && (ahead || (b = bufalloc()) == 0)){
+      if(ahead){
+        release(&bk->lock);
+        release(&bcache.lock);
+        return 0;
+      }
+      panic("bget: no buffers");
     }
+    xadd(ahead ? &bcache.ahead : &bcache.miss, 1);
+    b->dev = dev;
+    b->blockno = blockno;
+    b->flags = 0;
+    b->refcnt = 1;
+    b->hnext = bk->head;
+    bk->head = b;
   }
-  panic("bget: no buffers");
+  release(&bk->lock);
+  release(&bcache.lock);
+  acquiresleep(&b->lock);
+  return b;
 }
 
 // Return a locked buf with the contents of the indicated block.
@@ -98,13 +274,58 @@ bread(uint dev, uint blockno)
 {
   struct buf *b;
 
-  b = bget(dev, blockno);
+  b = bget(dev, blockno, 0);
   if((b->flags & B_VALID) == 0) {
     iderw(b);
   }
   return b;
 }
 
+// block을 읽기 시작만 하고 기다리지 않음 (readahead)
+// 읽는 동안 buffer는 lock된 상태로 남아, 먼저 bread한 process는 읽기가 끝날 때까지 기다림
+void
+breadahead(uint dev, uint blockno)
+{
+  struct buf *b;
+
+  if((b = bget(dev, blockno, 1)) == 0)
+    return;
+  if(b->flags & B_VALID){ // bget과 acquiresleep 사이에 다른 process가 먼저 읽음
+    brelse(b);
+    return;
+  }
+  iderwasync(b);
+}
+
+// buffer의 참조를 놓고, 사용하는 process가 없으면 MRU list의 앞으로 옮김
+static void
+bput(struct buf *b)
+{
+  struct bucket *bk = bucketof(b->dev, b->blockno);
+
+  acquire(&bk->lock);
+  b->refcnt--;
+  if (b->refcnt == 0) {
+    // no one is waiting for it.
+    acquire(&bcache.lrulock);
+    b->next = bcache.head.next;
+    b->prev = &bcache.head;
+    bcache.head.next->prev = b;
+    bcache.head.next = b;
+    release(&bcache.lrulock);
+  }
+  release(&bk->lock);
+}
+
+// iderwasync로 시작한 읽기가 끝났을 때 ideintr에서 호출
+// buffer를 lock한 process 대신 lock과 참조를 놓음
+void
+bdone(struct buf *b)
+{
+  releasesleep(&b->lock);
+  bput(b);
+}
+
 // Write b's contents to disk.  Must be locked.
 void
 bwrite(struct buf *b)
@@ -116,7 +337,7 @@ bwrite(struct buf *b)
 }
 
 // Release a locked buffer.
-// Move to the head of the MRU list.
+// If no one else uses it, move to the head of the MRU list.
 void
 brelse(struct buf *b)
 {
@@ -124,21 +345,15 @@ brelse(struct buf *b)
     panic("brelse");
 
   releasesleep(&b->lock);
-
-  acquire(&bcache.lock);
-  b->refcnt--;
-  if (b->refcnt == 0) {
-    // no one is waiting for it.
-    b->next->prev = b->prev;
-    b->prev->next = b->next;
-    b->next = bcache.head.next;
-    b->prev = &bcache.head;
-    bcache.head.next->prev = b;
-    bcache.head.next = b;
-  }
-  
-  release(&bcache.lock);
+  bput(b);
+}
+void
+getbcachestat(struct memstat *ms)
+{
+  ms->bcachebuf = bcache.nbuf;
+  ms->bcachehit = bcache.hit;
+  ms->bcachemiss = bcache.miss;
+  ms->bcacheahead = bcache.ahead;
 }
 //PAGEBREAK!
 // Blank page.
-
@@ -0,0 +1,41 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "memstat.h"
+
+// cat처럼 512 byte씩 file을 끝까지 읽으며 시간과 buffer cache counter를 출력
+// buffer cache에 없는 file을 읽어야 하므로 부팅 후 처음 실행할 때 측정 (기본값은 fs.img에서 가장 큰 program)
+// readahead가 동작하면 대부분의 block이 miss(기다리며 읽음)가 아닌 ahead(미리 읽음)로 count됨
+char buf[512];
+
+void
+catfile(char *path)
+{
+  struct memstat before, after;
+  int fd, n, total = 0, start;
+
+  if((fd = open(path, 0)) < 0){
+    printf(1, "cat bench: cannot open %s\n", path);
+    return;
+  }
+  memstat(&before);
+  start = uptime();
+  while((n = read(fd, buf, sizeof(buf))) > 0)
+    total += n;
+  memstat(&after);
+  close(fd);
+  printf(1, "%s: %d bytes, %d ticks, hit %d miss %d ahead %d\n", path, total, uptime() - start,
+         after.bcachehit - before.bcachehit, after.bcachemiss - before.bcachemiss,
+         after.bcacheahead - before.bcacheahead);
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf(1, "[cat bench]\n");
+  if(argc < 2)
+    catfile("usertests");
+  for(int i = 1; i < argc; i++)
+    catfile(argv[i]);
+  exit();
+}
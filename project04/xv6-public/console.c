@@ -237,7 +237,11 @@ consoleread(struct inode *ip, char *dst, int n)
 {
   uint target;
   int c;
+  char buf[INPUT_BUF], *p = buf;
 
+  // lock을 잡은 동안에는 kernel buffer로만 복사 (user page가 swap out되어 있으면 page fault handler가 sleep하므로)
+  if(n > sizeof(buf))
+    n = sizeof(buf);
   iunlock(ip);
   target = n;
   acquire(&cons.lock);
@@ -259,12 +263,13 @@ consoleread(struct inode *ip, char *dst, int n)
       }
       break;
     }
-    *dst++ = c;
+    *p++ = c;
     --n;
     if(c == '\n')
       break;
   }
   release(&cons.lock);
+  memmove(dst, buf, p - buf);
   ilock(ip);
 
   return target - n;
@@ -273,13 +278,21 @@ consoleread(struct inode *ip, char *dst, int n)
 int
 consolewrite(struct inode *ip, char *buf, int n)
 {
-  int i;
+  int i, j, m;
+  char kbuf[128];
 
   iunlock(ip);
-  acquire(&cons.lock);
-  for(i = 0; i < n; i++)
-    consputc(buf[i] & 0xff);
-  release(&cons.lock);
+  for(i = 0; i < n; i += m){
+    // lock을 잡기 전에 kernel buffer로 복사 (user page가 swap out되어 있으면 page fault handler가 sleep하므로)
+    m = n - i;
+    if(m > sizeof(kbuf))
+      m = sizeof(kbuf);
+    memmove(kbuf, buf + i, m);
+    acquire(&cons.lock);
+    for(j = 0; j < m; j++)
+      consputc(kbuf[j] & 0xff);
+    release(&cons.lock);
+  }
   ilock(ip);
 
   return n;
@@ -0,0 +1,52 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define PGSIZE     4096
+#define NPAGES     128  // parent가 child들과 공유하는 page 수
+#define ROUNDS     10
+#define MAXCHILD   8
+
+char *buf;
+
+int
+main(int argc, char *argv[])
+{
+  int start, elapsed, faults, initial_fp;
+
+  printf(1, "[CoW bench] parallel CoW faults on %d shared pages\n", NPAGES);
+
+  buf = sbrk(NPAGES * PGSIZE);
+  memset(buf, 0, NPAGES * PGSIZE);
+  initial_fp = countfp();
+
+  for(int n = 1; n <= MAXCHILD; n++){
+    start = uptime();
+    for(int r = 0; r < ROUNDS; r++){
+      // n개의 child가 동시에 같은 page들에 write하여 같은 page의 참조 횟수를 동시에 감소시킴
+      for(int c = 0; c < n; c++){
+        if(fork() == 0){
+          for(int i = 0; i < NPAGES; i++)
+            buf[i * PGSIZE] = c;
+          exit();
+        }
+      }
+      for(int c = 0; c < n; c++)
+        wait();
+    }
+    elapsed = uptime() - start;
+
+    faults = n * ROUNDS * NPAGES;
+    if(elapsed == 0)
+      elapsed = 1;
+    printf(1, "children %d: %d faults in %d ticks (%d faults/tick)\n", n, faults, elapsed, faults / elapsed);
+  }
+
+  // 모든 child가 종료되었으므로 child들이 할당받은 page가 모두 free 되었는지 확인
+  if(initial_fp != countfp())
+    printf(1, "[CoW bench] fail\n");
+  else
+    printf(1, "[CoW bench] done\n");
+
+  exit();
+}
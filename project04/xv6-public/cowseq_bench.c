@@ -0,0 +1,72 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "memstat.h"
+
+#define PGSIZE  4096
+#define NPAGE   1024  // fork 전에 할당하고 접근해두는 page 수 (4MB)
+#define NCHILD  4
+
+// child가 공유 중인 buffer의 모든 page에 write
+// seq가 1이면 순차적으로, 0이면 page 순서를 섞어서 write
+void
+writer(char *buf, int seq)
+{
+  int i, pg, start, fp_before, fp_after;
+  struct memstat before, after;
+
+  memstat(&before);
+  fp_before = countfp();
+  start = uptime();
+  for(i = 0; i < NPAGE; i++){
+    pg = seq ? i : (i * 509) % NPAGE; // 509는 NPAGE와 서로소이므로 모든 page를 한 번씩 방문
+    buf[pg * PGSIZE] = 2;
+  }
+  fp_after = countfp();
+  memstat(&after);
+  printf(1, "%s: %d ticks, %d pages copied, %d faults saved\n",
+         seq ? "sequential" : "scattered ", uptime() - start,
+         fp_before - fp_after, after.cowaround - before.cowaround);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, seq, pid;
+  char *buf;
+
+  if((buf = sbrk(NPAGE * PGSIZE)) == (char*)-1){
+    printf(1, "sbrk failed\n");
+    exit();
+  }
+  for(i = 0; i < NPAGE; i++)
+    buf[i * PGSIZE] = 1;
+
+  printf(1, "[CoW seq bench] %d children write %d shared pages\n", NCHILD, NPAGE);
+
+  for(seq = 1; seq >= 0; seq--){
+    for(i = 0; i < NCHILD; i++){
+      pid = fork();
+      if(pid < 0){
+        printf(1, "fork failed\n");
+        exit();
+      }
+      if(pid == 0){
+        sleep(10 * i); // 한 번에 하나의 child만 측정
+        writer(buf, seq);
+        exit();
+      }
+    }
+    for(i = 0; i < NCHILD; i++)
+      wait();
+  }
+
+  for(i = 0; i < NPAGE; i++){
+    if(buf[i * PGSIZE] != 1){
+      printf(1, "[CoW seq bench] fail\n");
+      exit();
+    }
+  }
+  printf(1, "[CoW seq bench] done\n");
+  exit();
+}
@@ -0,0 +1,69 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+
+#define NPROC   4
+#define NFILE   32          // process당 만드는 file 수
+#define FILESZ  512
+
+// stressfs처럼 NPROC개의 process가 동시에 작은 file을 만들고 지워 file 생성 처리량을 측정
+// 각 create/write/unlink가 하나의 transaction이므로, commit마다 home location에 쓰는 시간이 그대로 드러남
+char buf[FILESZ];
+
+void
+name(char *path, int p, int i)
+{
+  strcpy(path, "cb000");
+  path[2] = '0' + p;
+  path[3] = '0' + i / 10;
+  path[4] = '0' + i % 10;
+}
+
+void
+work(int p)
+{
+  char path[8];
+  int fd;
+
+  for(int i = 0; i < NFILE; i++){
+    name(path, p, i);
+    if((fd = open(path, O_CREATE | O_RDWR)) < 0){
+      printf(1, "create %s failed\n", path);
+      exit();
+    }
+    if(write(fd, buf, sizeof(buf)) != sizeof(buf)){
+      printf(1, "write %s failed\n", path);
+      exit();
+    }
+    close(fd);
+  }
+  for(int i = 0; i < NFILE; i++){
+    name(path, p, i);
+    unlink(path);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int start, t;
+
+  printf(1, "[create bench] %d processes x %d files of %d bytes\n", NPROC, NFILE, FILESZ);
+
+  memset(buf, 'c', sizeof(buf));
+  start = uptime();
+  for(int p = 0; p < NPROC; p++){
+    if(fork() == 0){
+      work(p);
+      exit();
+    }
+  }
+  for(int p = 0; p < NPROC; p++)
+    wait();
+  t = uptime() - start;
+
+  printf(1, "%d ticks, %d files/100 ticks\n", t, t ? NPROC * NFILE * 100 / t : 0);
+  printf(1, "OK\n");
+  exit();
+}
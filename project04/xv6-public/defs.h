@@ -1,5 +1,6 @@
 struct buf;
 struct context;
+struct execseg;
 struct file;
 struct inode;
 struct pipe;
@@ -7,14 +8,21 @@ struct proc;
 struct rtcdate;
 struct spinlock;
 struct sleeplock;
+struct slabcache;
 struct stat;
+struct memstat;
+struct procmem;
 struct superblock;
 
 // bio.c
 void            binit(void);
 struct buf*     bread(uint, uint);
+void            breadahead(uint, uint);
+void            bdone(struct buf*);
 void            brelse(struct buf*);
 void            bwrite(struct buf*);
+int             bshrink(int);
+void            getbcachestat(struct memstat*);
 
 // console.c
 void            consoleinit(void);
@@ -24,6 +32,13 @@ void            panic(char*) __attribute__((noreturn));
 
 // exec.c
 int             exec(char*, char**);
+void            execinit(void);
+int             loadimage(char*, char**, pde_t**, uint*, uint*, uint*, struct inode**, struct execseg*);
+int             inexecseg(struct proc*, uint);
+int             exec_fault(struct proc*, uint, int);
+void            execcache_drop(uint, uint);
+struct inode*   exedup(struct inode*);
+void            exeput(struct inode*);
 
 // file.c
 struct file*    filealloc(void);
@@ -57,6 +72,7 @@ int             writei(struct inode*, char*, uint, uint);
 void            ideinit(void);
 void            ideintr(void);
 void            iderw(struct buf*);
+void            iderwasync(struct buf*);
 
 // ioapic.c
 void            ioapicenable(int irq, int cpu);
@@ -65,13 +81,20 @@ void            ioapicinit(void);
 
 // kalloc.c
 char*           kalloc(void);
+char*           kalloc_type(int);
+char*           kalloc_zeroed(int);
+void            kzero_idle(void);
+char*           kalloc_huge(void);
+void            kfree_huge(char*);
+void            ksplit_huge(char*);
 void            kfree(char*);
 void            kinit1(void*, void*);
 void            kinit2(void*, void*);
 void            incr_refc(uint);
-void            decr_refc(uint);
+int             decr_refc(uint);
 int             get_refc(uint);
 int             countfp(void);
+void            getmemstat(struct memstat*);
 
 // kbd.c
 void            kbdintr(void);
@@ -85,11 +108,32 @@ void            lapicinit(void);
 void            lapicstartap(uchar, uint);
 void            microdelay(int);
 
+// ksm.c
+void            ksminit(void);
+void            ksm_page(struct proc*, uint);
+void            getksmstat(struct memstat*);
+
 // log.c
 void            initlog(int dev);
 void            log_write(struct buf*);
 void            begin_op();
 void            end_op();
+void            log_sync(void);
+int             log_interval(int);
+
+// mmap.c
+void            mmapinit(void);
+void            mapcache_rw(struct inode*, char*, uint, uint, int);
+uint            mmap(uint, int, int, struct file*, uint);
+int             munmap(uint, uint);
+int             vma_fault(struct proc*, uint, int);
+int             vma_uaccess(struct proc*, uint, uint, int);
+int             vma_prot(struct proc*, uint);
+int             vma_flags(struct proc*, uint);
+uint            vma_len(struct proc*, uint);
+int             vma_populate(struct proc*);
+void            vma_dup(struct proc*, struct proc*);
+void            vma_clear(struct proc*);
 
 // mp.c
 extern int      ismp;
@@ -100,6 +144,7 @@ void            picenable(int);
 void            picinit(void);
 
 // pipe.c
+void            pipeinit(void);
 int             pipealloc(struct file**, struct file**);
 void            pipeclose(struct pipe*, int);
 int             piperead(struct pipe*, char*, int);
@@ -112,6 +157,8 @@ void            exit(void);
 int             fork(void);
 int             growproc(int);
 int             kill(int);
+int             getprocmem(int, struct procmem*);
+int             setmemlimit(int, int);
 struct cpu*     mycpu(void);
 struct proc*    myproc();
 void            pinit(void);
@@ -120,6 +167,10 @@ void            scheduler(void) __attribute__((noreturn));
 void            sched(void);
 void            setproc(struct proc*);
 void            sleep(void*, struct spinlock*);
+void            kthread(char*, void (*)(void));
+char*           clock_evict(uint);
+void            ksm_scan(int);
+int             spawn(char*, char**, struct file**);
 void            userinit(void);
 int             wait(void);
 void            wakeup(void*);
@@ -128,6 +179,29 @@ void            yield(void);
 // swtch.S
 void            swtch(struct context**, struct context*);
 
+// shm.c
+void            shminit(void);
+int             shmget(int, uint);
+uint            shmat(int);
+int             shmdt(uint);
+int             shmrm(int);
+
+// swap.c
+void            swapinit(void);
+char*           kalloc_user(int);
+int             swapout(int);
+void            swap_read(uint, char*);
+void            swap_dup(uint);
+void            swap_free(uint);
+void            getswapstat(struct memstat*);
+
+// slab.c
+void            slabinit(void);
+struct slabcache* slab_create(char*, uint, void (*)(void*));
+void*           slab_alloc(struct slabcache*);
+void            slab_free(struct slabcache*, void*);
+void            slab_reclaim(struct slabcache*);
+
 // spinlock.c
 void            acquire(struct spinlock*);
 void            getcallerpcs(void*, uint*);
@@ -155,6 +229,7 @@ char*           strncpy(char*, const char*, int);
 // syscall.c
 int             argint(int, int*);
 int             argptr(int, char**, int);
+int             argwptr(int, char**, int);
 int             argstr(int, char**);
 int             fetchint(uint, int*);
 int             fetchstr(uint, char**);
@@ -189,10 +264,17 @@ void            switchuvm(struct proc*);
 void            switchkvm(void);
 int             copyout(pde_t*, uint, void*, uint);
 void            clearpteu(pde_t *pgdir, char *uva);
-void            CoW_handler(void);
+int             mapuserpage(pde_t*, uint, char*, int);
+int             ptedirty(pde_t*, char*);
+uint*           privpte(pde_t*, uint);
+void            touchuva(char*, int);
+int             swap_check(pde_t*, uint);
+char*           swap_unmap(pde_t*, uint, uint);
+int             pgfault_handler(uint);
 int             countvp(void);
 int             countpp(void);
 int             countptp(void);
+void            vmacct(struct proc*);
 
 // number of elements in fixed-size array
 #define NELEM(x) (sizeof(x)/sizeof((x)[0]))
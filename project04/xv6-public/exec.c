@@ -6,24 +6,213 @@
 #include "defs.h"
 #include "x86.h"
 #include "elf.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "file.h"
 
+// ELF segment는 exec에서 읽지 않고 처음 접근할 때 exec_fault에서 file을 읽어옴 (demand paging)
+// file 내용으로 가득 찬 page는 (dev, inum, file offset)으로 execcache에 보관하여, 같은 program을 실행하는
+// process들이 read-only로 공유하고 write하면 CoW로 복사함
+// cache가 1개의 참조를 가지며, file 내용이 바뀌면(writei, itrunc) execcache_drop으로 버림
+// 아직 읽어오지 않은 page는 실행 중에도 file에서 읽어오므로, 실행 중인 program file에는 write할 수 없음 (ip->execref)
+struct {
+  struct spinlock lock;
+  struct {
+    uint dev;
+    uint inum;
+    uint off;     // page의 file offset
+    char *page;   // 0이면 빈 항목
+  } ent[NEXECPG];
+  uint hand;      // cache가 가득 찼을 때 다음에 교체할 항목
+  uint gen;       // execcache_drop이 호출될 때마다 증가
+} execcache;
+
+void
+execinit(void)
+{
+  initlock(&execcache.lock, "execcache");
+}
+
+// cache에 있는 page의 참조 횟수를 증가시켜 반환, 없으면 0을 반환
+static char*
+execcache_get(uint dev, uint inum, uint off)
+{
+  char *page = 0;
+  int i;
+
+  acquire(&execcache.lock);
+  for(i = 0; i < NEXECPG; i++){
+    if(execcache.ent[i].page && execcache.ent[i].dev == dev &&
+       execcache.ent[i].inum == inum && execcache.ent[i].off == off){
+      page = execcache.ent[i].page;
+      incr_refc(V2P(page));
+      break;
+    }
+  }
+  release(&execcache.lock);
+  return page;
+}
+
+// file에서 새로 읽어온 page를 cache에 추가하고 공유할 page를 반환
+// 다른 process가 먼저 추가했다면 mem을 free하고 그 page를 반환하며,
+// 읽는 동안 file이 바뀌었다면(gen이 다름) cache에 넣지 않고 0을 반환
+static char*
+execcache_put(uint dev, uint inum, uint off, char *mem, uint gen)
+{
+  char *page;
+  int i, empty = -1;
+
+  acquire(&execcache.lock);
+  if(gen != execcache.gen){
+    release(&execcache.lock);
+    return 0;
+  }
+  for(i = 0; i < NEXECPG; i++){
+    page = execcache.ent[i].page;
+    if(page && execcache.ent[i].dev == dev && execcache.ent[i].inum == inum && execcache.ent[i].off == off){
+      incr_refc(V2P(page));
+      release(&execcache.lock);
+      kfree(mem);
+      return page;
+    }
+    if(page == 0 && empty < 0)
+      empty = i;
+  }
+  if(empty < 0){ // 가득 찼으면 순서대로 교체 (mapping한 process가 있으면 page는 그 process들이 계속 사용)
+    empty = execcache.hand;
+    execcache.hand = (execcache.hand + 1) % NEXECPG;
+    kfree(execcache.ent[empty].page);
+  }
+  execcache.ent[empty].dev = dev;
+  execcache.ent[empty].inum = inum;
+  execcache.ent[empty].off = off;
+  execcache.ent[empty].page = mem;
+  incr_refc(V2P(mem)); // cache가 가진 참조
+  release(&execcache.lock);
+  return mem;
+}
+
+// file 내용이 바뀌었으므로 cache에 남은 page를 버림
+void
+execcache_drop(uint dev, uint inum)
+{
+  int i;
+
+  acquire(&execcache.lock);
+  execcache.gen++;
+  for(i = 0; i < NEXECPG; i++){
+    if(execcache.ent[i].page && execcache.ent[i].dev == dev && execcache.ent[i].inum == inum){
+      kfree(execcache.ent[i].page);
+      execcache.ent[i].page = 0;
+    }
+  }
+  release(&execcache.lock);
+}
+
+// 실행 중인 program file(proc.exe)의 참조를 하나 더 만듦 (fork)
+struct inode*
+exedup(struct inode *ip)
+{
+  xadd(&ip->execref, 1);
+  return idup(ip);
+}
+
+// 실행 중인 program file의 참조를 놓음, 마지막 process가 놓으면 다시 write할 수 있음
+// iput을 호출하므로 transaction 안에서 호출해야 함
+void
+exeput(struct inode *ip)
+{
+  xadd(&ip->execref, -1);
+  iput(ip);
+}
+
+static struct execseg*
+findseg(struct proc *p, uint va)
+{
+  struct execseg *s;
+
+  if(p->exe == 0)
+    return 0;
+  for(s = p->execseg; s < &p->execseg[NEXECSEG]; s++)
+    if(s->filesz && va >= s->vaddr && PGROUNDDOWN(va) < s->vaddr + s->filesz)
+      return s;
+  return 0;
+}
+
+// va가 속한 page에 file에서 읽어와야 하는 내용이 있는지 확인
 int
-exec(char *path, char **argv)
+inexecseg(struct proc *p, uint va)
 {
-  char *s, *last;
-  int i, off;
+  return findseg(p, va) != 0;
+}
+
+// exec에서 읽지 않은 segment page에 처음 접근했을 때 호출
+// file 내용으로 가득 찬 page는 read만 했다면 execcache의 page를 read-only로 공유하고,
+// write했거나 bss와 걸쳐 있는 page는 새로운 page에 읽어와 writable로 mapping
+int
+exec_fault(struct proc *p, uint va, int write)
+{
+  struct execseg *s = findseg(p, va);
+  struct inode *ip = p->exe;
+  uint a = PGROUNDDOWN(va), off, n, gen;
+  char *mem, *page;
+  int perm = PTE_W | PTE_U;
+
+  off = s->off + (a - s->vaddr);
+  n = s->vaddr + s->filesz - a;
+  if(n > PGSIZE)
+    n = PGSIZE;
+  if(n == PGSIZE && !write && (mem = execcache_get(ip->dev, ip->inum, off)) != 0){
+    perm = PTE_U;
+  } else {
+    gen = execcache.gen;
+    if((mem = kalloc_user(n < PGSIZE)) == 0){ // bss와 걸쳐 있는 page는 file 내용 뒤가 0이어야 함
+      cprintf("exec_fault: out of memory\n");
+      return -1;
+    }
+    ilock(ip);
+    // cache에 넣기 전에 표시하여, 읽은 후 write되면 writei가 execcache_drop으로 gen을 바꾸도록 함
+    if(n == PGSIZE && !write)
+      ip->execcached = 1;
+    if(readi(ip, mem, off, n) != n){
+      iunlock(ip);
+      kfree(mem);
+      return -1;
+    }
+    iunlock(ip);
+    if(n == PGSIZE && !write && (page = execcache_put(ip->dev, ip->inum, off, mem, gen)) != 0){
+      mem = page;
+      perm = PTE_U;
+    }
+  }
+  // present가 아니던 PTE는 TLB에 남아있지 않으므로 TLB flush가 필요 X
+  if(mapuserpage(p->pgdir, a, mem, perm) < 0){
+    kfree(mem);
+    return -1;
+  }
+  return 0;
+}
+
+// path의 ELF로 새로운 user address space를 만들고 user stack에 argv를 복사
+// 현재 process는 변경하지 않으며, exec()과 spawn()이 만들어진 address space를 각자의 process에 설치
+// 성공하면 새로운 page directory, 크기, 시작 주소(entry), stack pointer와
+// program file(참조를 가짐), segment 정보(seg[NEXECSEG])를 반환하고 0을, 실패하면 -1을 반환
+int
+loadimage(char *path, char **argv, pde_t **pgdirp, uint *szp, uint *entryp, uint *spp,
+          struct inode **exep, struct execseg *seg)
+{
+  int i, n, off;
   uint argc, sz, sp, ustack[3+MAXARG+1];
   struct elfhdr elf;
-  struct inode *ip;
+  struct inode *ip, *exe = 0;
   struct proghdr ph;
-  pde_t *pgdir, *oldpgdir;
-  struct proc *curproc = myproc();
+  pde_t *pgdir;
 
   begin_op();
 
   if((ip = namei(path)) == 0){
     end_op();
-    cprintf("exec: fail\n");
     return -1;
   }
   ilock(ip);
@@ -39,8 +228,10 @@ exec(char *path, char **argv)
     goto bad;
 
   // Load program into memory.
+  // segment의 위치만 기록하고 file 내용은 처음 접근할 때 읽어옴
   sz = 0;
-  for(i=0, off=elf.phoff; i<elf.phnum; i++, off+=sizeof(ph)){
+  memset(seg, 0, NEXECSEG * sizeof(*seg));
+  for(i=0, n=0, off=elf.phoff; i<elf.phnum; i++, off+=sizeof(ph)){
     if(readi(ip, (char*)&ph, off, sizeof(ph)) != sizeof(ph))
       goto bad;
     if(ph.type != ELF_PROG_LOAD)
@@ -49,15 +240,26 @@ exec(char *path, char **argv)
       goto bad;
     if(ph.vaddr + ph.memsz < ph.vaddr)
       goto bad;
-    if((sz = allocuvm(pgdir, sz, ph.vaddr + ph.memsz)) == 0)
-      goto bad;
-    if(ph.vaddr % PGSIZE != 0)
+    if(ph.vaddr % PGSIZE != 0 || ph.vaddr + ph.memsz > MMAPBASE)
       goto bad;
-    if(loaduvm(pgdir, (char*)ph.vaddr, ip, ph.off, ph.filesz) < 0)
+    if(ph.off + ph.filesz < ph.off || ph.off + ph.filesz > ip->size)
       goto bad;
+    // file 내용이 없는 bss page는 다른 heap page처럼 처음 접근할 때 lazy_handler에서 mapping
+    if(ph.filesz > 0){
+      if(n == NEXECSEG)
+        goto bad;
+      seg[n].vaddr = ph.vaddr;
+      seg[n].filesz = ph.filesz;
+      seg[n].off = ph.off;
+      n++;
+    }
+    if(ph.vaddr + ph.memsz > sz)
+      sz = ph.vaddr + ph.memsz;
   }
-  iunlockput(ip);
+  xadd(&ip->execref, 1); // writei와 같이 inode lock 안에서 증가시켜, 이후의 write를 막음
+  iunlock(ip);
   end_op();
+  exe = ip; // segment의 page를 읽어오기 위해 참조를 유지
   ip = 0;
 
   // Allocate two pages at the next page boundary.
@@ -87,6 +289,43 @@ exec(char *path, char **argv)
   if(copyout(pgdir, sp, ustack, (3+argc+1)*4) < 0)
     goto bad;
 
+  *pgdirp = pgdir;
+  *szp = sz;
+  *entryp = elf.entry;
+  *spp = sp;
+  *exep = exe;
+  return 0;
+
+ bad:
+  if(pgdir)
+    freevm(pgdir);
+  if(ip){
+    iunlockput(ip);
+    end_op();
+  }
+  if(exe){
+    begin_op();
+    exeput(exe);
+    end_op();
+  }
+  return -1;
+}
+
+int
+exec(char *path, char **argv)
+{
+  char *s, *last;
+  uint sz, entry, sp;
+  pde_t *pgdir, *oldpgdir;
+  struct inode *exe, *oldexe;
+  struct execseg seg[NEXECSEG];
+  struct proc *curproc = myproc();
+
+  if(loadimage(path, argv, &pgdir, &sz, &entry, &sp, &exe, seg) < 0){
+    cprintf("exec: fail\n");
+    return -1;
+  }
+
   // Save program name for debugging.
   for(last=s=path; *s; s++)
     if(*s == '/')
@@ -94,21 +333,22 @@ exec(char *path, char **argv)
   safestrcpy(curproc->name, last, sizeof(curproc->name));
 
   // Commit to the user image.
+  vma_clear(curproc);
   oldpgdir = curproc->pgdir;
   curproc->pgdir = pgdir;
   curproc->sz = sz;
-  curproc->tf->eip = elf.entry;  // main
+  curproc->tf->eip = entry;  // main
   curproc->tf->esp = sp;
+  oldexe = curproc->exe;
+  curproc->exe = exe;
+  memmove(curproc->execseg, seg, sizeof(seg));
+  vmacct(curproc);
   switchuvm(curproc);
   freevm(oldpgdir);
-  return 0;
-
- bad:
-  if(pgdir)
-    freevm(pgdir);
-  if(ip){
-    iunlockput(ip);
+  if(oldexe){
+    begin_op();
+    exeput(oldexe);
     end_op();
   }
-  return -1;
+  return 0;
 }
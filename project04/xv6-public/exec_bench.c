@@ -0,0 +1,104 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "memstat.h"
+
+#define NEXEC  50  // usertests를 실행하는 횟수
+#define NSH    20  // 동시에 실행하는 sh 수
+
+// usertests.ran이 있으면 usertests는 바로 종료하므로, program을 실행하는 데 걸리는 시간만 측정할 수 있음
+void
+execlat(void)
+{
+  char *args[] = { "usertests", 0 };
+  int fds[3] = { 0, -1, 2 }; // usertests의 출력은 버림
+  int fd, created = 0, start;
+
+  if((fd = open("usertests.ran", 0)) < 0){
+    close(open("usertests.ran", O_CREATE));
+    created = 1;
+  } else
+    close(fd);
+
+  start = uptime();
+  for(int i = 0; i < NEXEC; i++){
+    if(spawn(args[0], args, fds) < 0){
+      printf(1, "spawn failed\n");
+      exit();
+    }
+    wait();
+  }
+  printf(1, "exec usertests: %d runs %d ticks\n", NEXEC, uptime() - start);
+
+  if(created)
+    unlink("usertests.ran");
+}
+
+// 입력을 기다리는 sh를 NSH개 실행한 상태에서 사용 중인 page 수를 측정
+void
+shmem(void)
+{
+  char *args[] = { "sh", 0 };
+  struct memstat before, after;
+  int in[2], err[2], fds[3];
+
+  // sh는 pipe에서 입력을 기다리고, prompt는 읽지 않는 pipe에 출력
+  if(pipe(in) < 0 || pipe(err) < 0){
+    printf(1, "pipe failed\n");
+    exit();
+  }
+  fds[0] = in[0];
+  fds[1] = 1;
+  fds[2] = err[1];
+
+  memstat(&before);
+  for(int i = 0; i < NSH; i++){
+    if(spawn(args[0], args, fds) < 0){
+      printf(1, "spawn failed\n");
+      exit();
+    }
+  }
+  sleep(100); // 모든 sh가 입력을 기다릴 때까지 대기
+  memstat(&after);
+
+  close(in[1]); // EOF를 받으면 sh가 종료
+  for(int i = 0; i < NSH; i++)
+    wait();
+  close(in[0]);
+  close(err[0]);
+  close(err[1]);
+
+  printf(1, "%d sh: %d pages (%d user pages), %d pages per sh\n", NSH,
+         before.free - after.free, after.user - before.user, (before.free - after.free) / NSH);
+}
+
+// 실행 중인 program file은 page를 나중에 읽어오므로 write할 수 없어야 함
+void
+textbusy(char *path)
+{
+  char c = 0;
+  int fd;
+
+  if((fd = open(path, O_RDWR)) < 0){
+    printf(1, "open %s failed\n", path);
+    exit();
+  }
+  if(write(fd, &c, 1) >= 0){
+    printf(1, "FAIL: write to running program %s succeeded\n", path);
+    exit();
+  }
+  close(fd);
+  printf(1, "write to running program refused\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf(1, "[exec bench] start\n");
+  textbusy(argv[0]);
+  execlat();
+  shmem();
+  printf(1, "[exec bench] done\n");
+  exit();
+}
@@ -0,0 +1,55 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "memstat.h"
+
+#define PGSIZE  4096
+#define NPG     1024  // 한 번에 fault를 발생시키는 page 수 (kzero pool 크기)
+#define ROUNDS  20
+
+// sbrk로 늘린 NPG개의 page에 처음 write하여 page fault를 발생시키고 걸린 tick을 반환
+int
+touch(void)
+{
+  char *p;
+  int start, elapsed;
+
+  if((p = sbrk(NPG * PGSIZE)) == (char*)-1){
+    printf(1, "sbrk failed\n");
+    exit();
+  }
+  start = uptime();
+  for(int i = 0; i < NPG; i++)
+    p[i * PGSIZE] = 1;
+  elapsed = uptime() - start;
+  sbrk(-NPG * PGSIZE);
+  return elapsed;
+}
+
+// wait 동안 idle CPU가 pool을 채울 수 있도록 한 뒤 page fault에 걸리는 시간을 측정
+void
+run(char *name, int wait)
+{
+  struct memstat before, after;
+  int ticks = 0;
+
+  memstat(&before);
+  for(int r = 0; r < ROUNDS; r++){
+    if(wait)
+      sleep(wait);
+    ticks += touch();
+  }
+  memstat(&after);
+  printf(1, "%s: %d faults %d ticks, zeroed on fault %d, pool %d\n",
+         name, ROUNDS * NPG, ticks, after.zeromiss - before.zeromiss, after.zeropool);
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf(1, "[fault bench] start\n");
+  run("pool refilled", 20);
+  run("back to back", 0);
+  printf(1, "[fault bench] done\n");
+  exit();
+}
@@ -9,17 +9,21 @@
 #include "spinlock.h"
 #include "sleeplock.h"
 #include "file.h"
+#include "stat.h"
 
 struct devsw devsw[NDEV];
+// struct file은 열 때 slab cache에서 할당하고 마지막으로 닫을 때 돌려줌 (시스템 전체에 최대 NFILE개)
 struct {
-  struct spinlock lock;
-  struct file file[NFILE];
+  struct spinlock lock;  // ref를 보호
+  int nfile;             // 할당된 struct file 수
+  struct slabcache *cache;
 } ftable;
 
 void
 fileinit(void)
 {
   initlock(&ftable.lock, "ftable");
+  ftable.cache = slab_create("file", sizeof(struct file), 0);
 }
 
 // Allocate a file structure.
@@ -29,15 +33,22 @@ filealloc(void)
   struct file *f;
 
   acquire(&ftable.lock);
-  for(f = ftable.file; f < ftable.file + NFILE; f++){
-    if(f->ref == 0){
-      f->ref = 1;
-      release(&ftable.lock);
-      return f;
-    }
+  if(ftable.nfile >= NFILE){
+    release(&ftable.lock);
+    return 0;
   }
+  ftable.nfile++;
   release(&ftable.lock);
-  return 0;
+
+  if((f = slab_alloc(ftable.cache)) == 0){
+    acquire(&ftable.lock);
+    ftable.nfile--;
+    release(&ftable.lock);
+    return 0;
+  }
+  memset(f, 0, sizeof(*f));
+  f->ref = 1;
+  return f;
 }
 
 // Increment ref count for file f.
@@ -66,9 +77,9 @@ fileclose(struct file *f)
     return;
   }
   ff = *f;
-  f->ref = 0;
-  f->type = FD_NONE;
+  ftable.nfile--;
   release(&ftable.lock);
+  slab_free(ftable.cache, f);
 
   if(ff.type == FD_PIPE)
     pipeclose(ff.pipe, ff.writable);
@@ -84,6 +95,7 @@ int
 filestat(struct file *f, struct stat *st)
 {
   if(f->type == FD_INODE){
+    touchuva((char*)st, sizeof(*st));
     ilock(f->ip);
     stati(f->ip, st);
     iunlock(f->ip);
@@ -103,6 +115,7 @@ fileread(struct file *f, char *addr, int n)
   if(f->type == FD_PIPE)
     return piperead(f->pipe, addr, n);
   if(f->type == FD_INODE){
+    touchuva(addr, n); // page fault가 발생하지 않도록 inode lock을 잡기 전에 접근
     ilock(f->ip);
     if((r = readi(f->ip, addr, f->off, n)) > 0)
       f->off += r;
@@ -137,6 +150,7 @@ filewrite(struct file *f, char *addr, int n)
       if(n1 > max)
         n1 = max;
 
+      touchuva(addr + i, n1); // page fault가 발생하지 않도록 inode lock을 잡기 전에 접근
       begin_op();
       ilock(f->ip);
       if ((r = writei(f->ip, addr + i, f->off, n1)) > 0)
@@ -23,6 +23,12 @@ struct inode {
   short nlink;
   uint size;
   uint addrs[NDIRECT+1];
+
+  uint ranext;        // 순차적으로 read한다면 다음 readi가 시작할 block
+  uint rawin;         // readahead window (block 수), 0이면 readahead하지 않음
+  uint raend;         // readahead를 시작한 마지막 block + 1
+  uint execref;       // 이 file을 실행 중인 program(proc.exe)으로 사용하는 process 수, 0이 아니면 write할 수 없음
+  int execcached;     // execcache에 이 file의 page가 있을 수 있으면 1 (0이면 writei, itrunc에서 execcache를 확인하지 않음)
 };
 
 // table mapping major device number to
@@ -0,0 +1,74 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define PGSIZE  4096
+#define SIZE    (64*1024*1024)  // fork 전에 할당하고 접근해두는 크기
+#define NFORK   100
+#define PTSPAN  (4*1024*1024)   // page table 하나가 mapping하는 크기
+
+// NFORK번 fork하고 child가 바로 exit할 때까지의 tick 수를 반환
+// unshare가 0이 아니면 child가 4MB 영역마다 한 page씩 write하여 모든 page table을 복사하게 만듦
+// (page table을 공유하지 않고 fork에서 모든 PTE를 복사하던 방식과 같은 양의 PTE 복사가 일어남)
+int
+forkloop(char *p, int unshare)
+{
+  int start, pid;
+
+  start = uptime();
+  for(int i = 0; i < NFORK; i++){
+    pid = fork();
+    if(pid < 0){
+      printf(1, "fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      if(unshare)
+        for(int off = 0; off < SIZE; off += PTSPAN)
+          p[off] = 3;
+      exit();
+    }
+    wait();
+  }
+  return uptime() - start;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int shared, copied, pid, fp_before, fp_after;
+  char *p;
+
+  if((p = sbrk(SIZE)) == (char*)-1){
+    printf(1, "sbrk failed\n");
+    exit();
+  }
+  for(int i = 0; i < SIZE / PGSIZE; i++) // 모든 page를 실제로 할당
+    p[i * PGSIZE] = 1;
+
+  printf(1, "[fork bench] %d forks of a %d MB process\n", NFORK, SIZE / (1024*1024));
+
+  // page table을 공유하므로 child가 바로 exit하면 page table도 복사되지 않아야 함
+  // 비교를 위해 child가 모든 page table을 복사하게 만든 경우(이전 방식의 PTE 복사량)도 측정
+  shared = forkloop(p, 0);
+  copied = forkloop(p, 1);
+  printf(1, "fork+exit+wait: shared page tables %d ticks, all page tables copied %d ticks\n", shared, copied);
+
+  // child가 한 page에만 write하면 page table 1개와 data page 1개만 복사되어야 함
+  pid = fork();
+  if(pid == 0){
+    fp_before = countfp();
+    p[0] = 2;
+    fp_after = countfp();
+    printf(1, "child write 1 page: %d pages copied (expected 2)\n", fp_before - fp_after);
+    exit();
+  }
+  wait();
+
+  if(p[0] != 1)
+    printf(1, "[fork bench] fail\n");
+  else
+    printf(1, "[fork bench] done\n");
+
+  exit();
+}
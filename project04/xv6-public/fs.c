@@ -266,6 +266,8 @@ iget(uint dev, uint inum)
   ip->inum = inum;
   ip->ref = 1;
   ip->valid = 0;
+  ip->ranext = ip->rawin = ip->raend = 0;
+  ip->execcached = 1; // 이전에 cache에서 나간 inode라면 execcache에 page가 남아 있을 수 있음
   release(&icache.lock);
 
   return ip;
@@ -411,6 +413,10 @@ itrunc(struct inode *ip)
   struct buf *bp;
   uint *a;
 
+  if(ip->type == T_FILE && ip->execcached){ // 실행 중인 program의 page를 공유하는 cache에서 제거 (inode 번호가 재사용될 수 있음)
+    execcache_drop(ip->dev, ip->inum);
+    ip->execcached = 0;
+  }
   for(i = 0; i < NDIRECT; i++){
     if(ip->addrs[i]){
       bfree(ip->dev, ip->addrs[i]);
@@ -447,6 +453,32 @@ stati(struct inode *ip, struct stat *st)
 }
 
 //PAGEBREAK!
+// file의 [off, off+n)을 readi하기 전에 호출
+// 직전 readi가 끝난 block에서 이어서 읽으면 순차 read로 보고, 뒤따르는 block들을 기다리지 않고 미리 읽기 시작
+// 순차 read가 이어질수록 window를 2배씩(최대 RAMAX block) 늘리고, 순차적이지 않으면 readahead를 멈춤
+#define RAMIN 4
+#define RAMAX 64
+
+static void
+readahead(struct inode *ip, uint off, uint n)
+{
+  uint bn = off / BSIZE, last = (off + n - 1) / BSIZE, end;
+
+  if(bn == ip->ranext || (bn + 1 == ip->ranext && off % BSIZE != 0)) // 앞 readi가 block 중간에서 끝난 경우 포함
+    ip->rawin = ip->rawin ? min(ip->rawin * 2, RAMAX) : RAMIN;
+  else
+    ip->rawin = 0;
+  ip->ranext = last + 1;
+  if(ip->rawin == 0)
+    return;
+
+  end = min(last + 1 + ip->rawin, (ip->size + BSIZE - 1) / BSIZE);
+  if(ip->raend < last + 1 || ip->raend > end)
+    ip->raend = last + 1;
+  for(; ip->raend < end; ip->raend++)
+    breadahead(ip->dev, bmap(ip, ip->raend));
+}
+
 // Read data from inode.
 // Caller must hold ip->lock.
 int
@@ -466,12 +498,17 @@ readi(struct inode *ip, char *dst, uint off, uint n)
   if(off + n > ip->size)
     n = ip->size - off;
 
+  if(ip->type == T_FILE && n > 0)
+    readahead(ip, off, n);
+
   for(tot=0; tot<n; tot+=m, off+=m, dst+=m){
     bp = bread(ip->dev, bmap(ip, off/BSIZE));
     m = min(n - tot, BSIZE - off%BSIZE);
     memmove(dst, bp->data + off%BSIZE, m);
     brelse(bp);
   }
+  if(ip->type == T_FILE) // MAP_SHARED로 mapping한 page에 store한 내용은 아직 disk block에 없을 수 있음
+    mapcache_rw(ip, dst - n, off - n, n, 0);
   return n;
 }
 
@@ -494,6 +531,12 @@ writei(struct inode *ip, char *src, uint off, uint n)
     return -1;
   if(off + n > MAXFILE*BSIZE)
     return -1;
+  if(ip->type == T_FILE && ip->execref > 0) // 실행 중인 program file (ETXTBSY)
+    return -1;
+  if(ip->type == T_FILE && ip->execcached){ // file 내용이 바뀌므로 execcache에 남은 program page를 버림
+    execcache_drop(ip->dev, ip->inum);
+    ip->execcached = 0;
+  }
 
   for(tot=0; tot<n; tot+=m, off+=m, src+=m){
     bp = bread(ip->dev, bmap(ip, off/BSIZE));
@@ -502,6 +545,8 @@ writei(struct inode *ip, char *src, uint off, uint n)
     log_write(bp);
     brelse(bp);
   }
+  if(ip->type == T_FILE) // MAP_SHARED로 mapping한 page에도 반영
+    mapcache_rw(ip, src - n, off - n, n, 1);
 
   if(n > 0 && off > ip->size){
     ip->size = off;
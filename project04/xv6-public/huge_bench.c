@@ -0,0 +1,70 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "memstat.h"
+
+#define PGSIZE      4096
+#define HUGEPGSIZE  (4*1024*1024)
+#define SIZE        (64*1024*1024)  // random access할 영역의 크기
+#define NACCESS     (4*1024*1024)
+
+// 64MB 영역을 할당하여 모든 page에 접근한 뒤, 임의의 page들에 NACCESS번 접근하는 시간을 측정
+void
+run(int huge)
+{
+  char *p;
+  uint base, x;
+  int start, fault_ticks, access_ticks;
+  struct memstat ms;
+
+  hugepage(huge);
+  // hugepage는 4MB 단위로 정렬된 영역에만 mapping되므로 정렬할 수 있도록 4MB를 더 할당
+  if((p = sbrk(SIZE + HUGEPGSIZE)) == (char*)-1){
+    printf(1, "sbrk failed\n");
+    exit();
+  }
+  base = ((uint)p + HUGEPGSIZE - 1) & ~(HUGEPGSIZE - 1);
+  p = (char*)base;
+
+  start = uptime();
+  for(int i = 0; i < SIZE / PGSIZE; i++)
+    p[i * PGSIZE] = 1;
+  fault_ticks = uptime() - start;
+  memstat(&ms);
+
+  x = 1;
+  start = uptime();
+  for(int i = 0; i < NACCESS; i++){
+    x = x * 1103515245 + 12345; // 선형 합동 생성기로 임의의 page 선택
+    p[((x >> 8) % (SIZE / PGSIZE)) * PGSIZE + (i & (PGSIZE - 1))]++;
+  }
+  access_ticks = uptime() - start;
+
+  printf(1, "%s: first touch %d ticks, %d random accesses %d ticks, free hugepages %d\n",
+         huge ? "4MB pages" : "4KB pages", fault_ticks, NACCESS, access_ticks, ms.hugefree);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int pid;
+
+  printf(1, "[hugepage bench] random access over %d MB\n", SIZE / (1024*1024));
+
+  // hugepage를 쓰는 경우와 쓰지 않는 경우를 각각 새로운 process에서 측정
+  for(int huge = 1; huge >= 0; huge--){
+    pid = fork();
+    if(pid < 0){
+      printf(1, "fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      run(huge);
+      exit();
+    }
+    wait();
+  }
+
+  printf(1, "[hugepage bench] done\n");
+  exit();
+}
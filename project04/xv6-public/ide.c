@@ -75,7 +75,7 @@ idestart(struct buf *b)
 {
   if(b == 0)
     panic("idestart");
-  if(b->blockno >= FSSIZE)
+  if(b->blockno >= FSSIZE + NSWAPBLK)
     panic("incorrect blockno");
   int sector_per_block =  BSIZE/SECTOR_SIZE;
   int sector = b->blockno * sector_per_block;
@@ -122,6 +122,10 @@ ideintr(void)
   b->flags |= B_VALID;
   b->flags &= ~B_DIRTY;
   wakeup(b);
+  if(b->flags & B_ASYNC){ // 기다리는 process가 없는 readahead이므로 buffer를 대신 놓음
+    b->flags &= ~B_ASYNC;
+    bdone(b);
+  }
 
   // Start disk on next buf in queue.
   if(idequeue != 0)
@@ -166,3 +170,28 @@ iderw(struct buf *b)
 
   release(&idelock);
 }
+
+// b를 disk에서 읽기 시작하고 끝날 때까지 기다리지 않음 (readahead)
+// 읽기가 끝나면 ideintr가 bdone으로 b의 lock과 참조를 놓으므로, 호출한 쪽은 이후 b를 사용하면 안 됨
+void
+iderwasync(struct buf *b)
+{
+  struct buf **pp;
+
+  if(!holdingsleep(&b->lock))
+    panic("iderwasync: buf not locked");
+  if(b->flags & (B_VALID|B_DIRTY))
+    panic("iderwasync: not a read");
+  if(b->dev != 0 && !havedisk1)
+    panic("iderw: ide disk 1 not present");
+
+  acquire(&idelock);
+  b->flags |= B_ASYNC;
+  b->qnext = 0;
+  for(pp=&idequeue; *pp; pp=&(*pp)->qnext)
+    ;
+  *pp = b;
+  if(idequeue == b)
+    idestart(b);
+  release(&idelock);
+}
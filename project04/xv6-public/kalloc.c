@@ -8,10 +8,18 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "spinlock.h"
+#include "x86.h"
+#include "memstat.h"
+
+#define KCACHE_BATCH  32              // 전역 freelist와 per-CPU cache 사이에서 한 번에 옮기는 page 수
+#define KCACHE_MAX    (2*KCACHE_BATCH) // per-CPU cache가 가질 수 있는 최대 page 수
+#define KZERO_MAX     1024            // 미리 0으로 채워둘 page 수
+#define KZERO_IDLE    8               // idle 상태의 CPU가 한 번에 0으로 채우는 page 수
 
 void freerange(void *vstart, void *vend);
 extern char end[]; // first address after kernel loaded from ELF file
                    // defined by the kernel linker script in kernel.ld
+extern volatile uint cowaround; // vm.c
 
 struct run {
   struct run *next;
@@ -21,14 +29,48 @@ struct {
   struct spinlock lock;
   int use_lock;
   struct run *freelist;
+  int nfree;  // freelist에 있는 page 수
 } kmem;
 
-struct {
+// CPU마다 가지는 free page cache
+// 보통은 자신의 CPU에서만 접근하므로 lock은 경쟁 없이 바로 잡히고,
+// 전역 freelist가 비었을 때 다른 CPU가 kcache_steal로 page를 가져가는 경우에만 경쟁
+struct kcache {
   struct spinlock lock;
-  int use_lock;
-  uint refc_arr[PHYSTOP / PGSIZE];  // PHYSTOP : Physical memory 범위 , PGSIZE : Physical page 크기
+  struct run *freelist;
+  int nfree;
+} kcache[NCPU];
+
+// page 참조 횟수는 lock 없이 lock xadd로 원자적으로 갱신
+struct {
+  volatile uint refc_arr[PHYSTOP / PGSIZE];  // PHYSTOP : Physical memory 범위 , PGSIZE : Physical page 크기
+  volatile uint nshared;                     // 참조 횟수가 1보다 큰 page 수
 } refc;
 
+// 4MB hugepage로 사용할 연속된 physical memory 영역
+// 4KB page의 freelist에서는 연속된 영역을 찾기 어려우므로 kinit2에서 HUGEPGSIZE 단위로 정렬된 영역을 미리 떼어둠
+struct {
+  struct spinlock lock;
+  struct run *freelist;
+  int nfree;  // freelist에 있는 4MB 영역 수
+} khuge;
+
+// 미리 0으로 채워둔 page pool
+// idle 상태의 CPU가 scheduler에서 kzero_idle()로 채우고, kalloc_zeroed()가 memset 없이 꺼내 씀
+// pool의 page는 kalloc_type(PG_KERNEL)으로 할당된 상태(참조 횟수 1)이며, 첫 4 byte(run.next)를 제외하고 0
+struct {
+  struct spinlock lock;
+  struct run *freelist;
+  int nfree;
+  volatile uint miss;  // pool이 비어 있어 kalloc_zeroed에서 직접 memset한 횟수
+} kzero;
+
+// memstat을 위해 page 용도별 사용 중인 page 수를 유지
+struct {
+  uchar type[PHYSTOP / PGSIZE];  // 각 page가 할당될 때의 용도
+  volatile uint npages[NPGTYPE]; // 용도별 사용 중인 page 수
+} pgstat;
+
 // Initialization happens in two phases.
 // 1. main() calls kinit1() while still using entrypgdir to place just
 // the pages mapped by entrypgdir on free list.
@@ -38,18 +80,35 @@ void
 kinit1(void *vstart, void *vend)
 {
   initlock(&kmem.lock, "kmem");
-  initlock(&refc.lock, "refc"); // refc locking 추가
+  initlock(&kzero.lock, "kzero");
+  for(int i = 0; i < NCPU; i++)
+    initlock(&kcache[i].lock, "kcache");
   kmem.use_lock = 0;
-  refc.use_lock = 0; // refc locking 추가
   freerange(vstart, vend);
 }
 
 void
 kinit2(void *vstart, void *vend)
 {
-  freerange(vstart, vend);
+  char *hstart, *hend, *p;
+
+  // 끝부분에서 최대 NHUGEPG개의 4MB 영역을 hugepage용으로 떼어두고, 나머지는 4KB page로 사용
+  initlock(&khuge.lock, "khuge");
+  hend = (char*)((uint)vend & ~(HUGEPGSIZE-1));
+  hstart = hend - NHUGEPG*HUGEPGSIZE;
+  if(hstart < (char*)vstart)
+    hstart = (char*)(((uint)vstart + HUGEPGSIZE-1) & ~(HUGEPGSIZE-1));
+  if(hstart > hend)
+    hstart = hend;
+
+  freerange(vstart, hstart);
+  for(p = hstart; p + HUGEPGSIZE <= hend; p += HUGEPGSIZE){
+    ((struct run*)p)->next = khuge.freelist;
+    khuge.freelist = (struct run*)p;
+    khuge.nfree++;
+  }
+  freerange(hend, vend);
   kmem.use_lock = 1;
-  refc.use_lock = 1; // refc locking 추가
 }
 
 void
@@ -58,11 +117,51 @@ freerange(void *vstart, void *vend)
   char *p;
   p = (char*)PGROUNDUP((uint)vstart);
   for(; p + PGSIZE <= (char*)vend; p += PGSIZE){
-    refc.refc_arr[V2P(p) / PGSIZE] = 0; // p에 대해서만 refc_arr을 0으로 초기화, freerange 호출 시에는 use_lock이 0이므로 locking 해줄 필요 X
+    refc.refc_arr[V2P(p) / PGSIZE] = 1; // kfree에서 참조 횟수를 1 감소시켜 0이 되어야 freelist에 추가되므로 1로 초기화
     kfree(p);
   }
 }
 
+// 전역 freelist에서 최대 KCACHE_BATCH개의 page를 가져와 per-CPU cache를 채움
+// c->lock을 잡은 상태에서 호출되어야 함
+static void
+kcache_refill(struct kcache *c)
+{
+  struct run *r;
+  int n;
+
+  acquire(&kmem.lock);
+  for(n = 0; n < KCACHE_BATCH && (r = kmem.freelist) != 0; n++){
+    kmem.freelist = r->next;
+    r->next = c->freelist;
+    c->freelist = r;
+  }
+  kmem.nfree -= n;
+  c->nfree += n;
+  release(&kmem.lock);
+}
+
+// per-CPU cache의 page 중 KCACHE_BATCH개를 전역 freelist로 돌려보냄
+// c->lock을 잡은 상태에서 호출되어야 함
+static void
+kcache_drain(struct kcache *c)
+{
+  struct run *head, *tail;
+  int n;
+
+  head = tail = c->freelist;
+  for(n = 1; n < KCACHE_BATCH && tail->next != 0; n++)
+    tail = tail->next;
+  c->freelist = tail->next;
+  c->nfree -= n;
+
+  acquire(&kmem.lock);
+  tail->next = kmem.freelist;
+  kmem.freelist = head;
+  kmem.nfree += n;
+  release(&kmem.lock);
+}
+
 //PAGEBREAK: 21
 // Free the page of physical memory pointed at by v,
 // which normally should have been returned by a
@@ -72,29 +171,132 @@ void
 kfree(char *v)
 {
   struct run *r;
+  struct kcache *c;
 
   if((uint)v % PGSIZE || v < end || V2P(v) >= PHYSTOP)
     panic("kfree");
 
-  if(kmem.use_lock)
-    acquire(&kmem.lock);
-  r = (struct run*)v;
-  
-  if(get_refc(V2P(v)) == 0 || get_refc(V2P(v)) == 1){
-  if(get_refc(V2P(v)) == 1)
-    decr_refc(V2P(v));
+  // 참조 횟수 감소와 확인을 원자적으로 처리하여, 마지막으로 참조하던 process만 page를 free
+  if(decr_refc(V2P(v)) > 0) // 다른 process가 아직 page를 공유하고 있다면 참조 횟수만 감소
+    return;
+  if(pgstat.type[V2P(v) / PGSIZE] != PG_KERNEL)
+    xadd(&pgstat.npages[pgstat.type[V2P(v) / PGSIZE]], -1);
+
+#ifdef KALLOC_DEBUG
   // Fill with junk to catch dangling refs.
   memset(v, 1, PGSIZE);
-  r->next = kmem.freelist;
-  kmem.freelist = r;
-  }
+#endif
+  r = (struct run*)v;
 
-  else if(get_refc(V2P(v)) > 1){
-    decr_refc(V2P(v));
+  if(!kmem.use_lock){ // kinit 단계에서는 cpus가 아직 설정되지 않았으므로 전역 freelist에 바로 추가
+    r->next = kmem.freelist;
+    kmem.freelist = r;
+    kmem.nfree++;
+    return;
   }
 
-  if(kmem.use_lock)
+  pushcli();
+  c = &kcache[cpuid()];
+  acquire(&c->lock);
+  r->next = c->freelist;
+  c->freelist = r;
+  c->nfree++;
+  if(c->nfree >= KCACHE_MAX)
+    kcache_drain(c);
+  release(&c->lock);
+  popcli();
+}
+
+// 전역 freelist와 자신의 cache가 모두 비었을 때 호출
+// 다른 CPU의 cache에 남은 page를 모두 전역 freelist로 옮기고, 옮긴 page가 있으면 1을 반환
+// (kcache lock을 2개 동시에 잡지 않도록 전역 freelist를 거침)
+static int
+kcache_steal(void)
+{
+  struct run *head, *tail;
+  struct kcache *c;
+  int n, moved = 0;
+
+  for(c = kcache; c < &kcache[NCPU]; c++){
+    if(c->nfree == 0)
+      continue;
+    acquire(&c->lock);
+    head = c->freelist;
+    n = c->nfree;
+    c->freelist = 0;
+    c->nfree = 0;
+    release(&c->lock);
+    if(head == 0)
+      continue;
+    for(tail = head; tail->next != 0; tail = tail->next)
+      ;
+    acquire(&kmem.lock);
+    tail->next = kmem.freelist;
+    kmem.freelist = head;
+    kmem.nfree += n;
     release(&kmem.lock);
+    moved = 1;
+  }
+  return moved;
+}
+
+// 자신의 CPU의 cache(비었으면 전역 freelist에서 채움)에서 page 하나를 꺼냄, 없으면 0을 반환
+static struct run*
+kcache_pop(void)
+{
+  struct run *r;
+  struct kcache *c;
+
+  pushcli();
+  c = &kcache[cpuid()];
+  acquire(&c->lock);
+  if(c->freelist == 0)
+    kcache_refill(c);
+  r = c->freelist;
+  if(r){
+    c->freelist = r->next;
+    c->nfree--;
+  }
+  release(&c->lock);
+  popcli();
+  return r;
+}
+
+// 4MB 영역을 khuge.freelist에서 꺼냄
+static struct run*
+khuge_pop(void)
+{
+  struct run *r;
+
+  acquire(&khuge.lock);
+  r = khuge.freelist;
+  if(r){
+    khuge.freelist = r->next;
+    khuge.nfree--;
+  }
+  release(&khuge.lock);
+  return r;
+}
+
+// 0으로 채워둔 page를 kzero pool에서 꺼냄
+// kinit 단계(kvmalloc이 kpgdir을 만들 때 등)에는 cpus가 아직 설정되지 않아 lock을 잡을 수 없고 pool도 비어 있으므로 건너뜀
+static struct run*
+kzero_pop(void)
+{
+  struct run *r;
+
+  if(!kmem.use_lock)
+    return 0;
+  acquire(&kzero.lock);
+  r = kzero.freelist;
+  if(r){
+    kzero.freelist = r->next;
+    kzero.nfree--;
+  }
+  release(&kzero.lock);
+  if(r)
+    r->next = 0;
+  return r;
 }
 
 // Allocate one 4096-byte page of physical memory.
@@ -102,80 +304,204 @@ kfree(char *v)
 // Returns 0 if the memory cannot be allocated.
 char*
 kalloc(void)
+{
+  return kalloc_type(PG_KERNEL);
+}
+
+// kalloc과 동일하지만, memstat에서 page가 type 용도로 집계되도록 기록
+char*
+kalloc_type(int type)
 {
   struct run *r;
 
-  if(kmem.use_lock)
-    acquire(&kmem.lock);
-  if(refc.use_lock)
-    acquire(&refc.lock);
+  if(!kmem.use_lock){
+    r = kmem.freelist;
+    if(r){
+      kmem.freelist = r->next;
+      kmem.nfree--;
+    }
+  } else {
+retry:
+    r = kcache_pop();
 
-  r = kmem.freelist;
+    // 다른 CPU의 cache에 남은 page가 있으면 가져와서 다시 시도 (countfp는 이 page들도 free page로 집계)
+    if(r == 0 && kcache_steal())
+      goto retry;
+    // 4KB page가 모두 소진되면 hugepage용 영역 하나를 4KB page들로 나누어 사용
+    if(r == 0 && (r = khuge_pop()) != 0){
+      freerange(r, (char*)r + HUGEPGSIZE);
+      goto retry;
+    }
+    // 그래도 없으면 0으로 채워둔 page를 사용
+    if(r == 0)
+      r = kzero_pop();
+  }
 
+  // 새로 page가 할당될 때 해당 page 참조 횟수를 1으로 설정
+  // 아직 아무도 참조하지 않는 page이므로 원자적으로 갱신할 필요 X
   if(r){
-    kmem.freelist = r->next;
-    refc.refc_arr[V2P(r) / PGSIZE] = 1; // 새로 page가 할당될 때 해당 page 참조 횟수를 1으로 설정
+    refc.refc_arr[V2P(r) / PGSIZE] = 1;
+    pgstat.type[V2P(r) / PGSIZE] = type;
+    if(type != PG_KERNEL)
+      xadd(&pgstat.npages[type], 1);
   }
 
-  if(kmem.use_lock)
-    release(&kmem.lock);
-  if(refc.use_lock)
-    release(&refc.lock);
+  return (char*)r;
+}
+
+// kalloc_type과 동일하지만 0으로 채워진 page를 반환
+// idle CPU가 미리 0으로 채워둔 page가 있으면 memset 없이 바로 반환
+char*
+kalloc_zeroed(int type)
+{
+  struct run *r;
+
+  if((r = kzero_pop()) == 0){
+    xadd(&kzero.miss, 1);
+    if((r = (struct run*)kalloc_type(type)) != 0)
+      memset(r, 0, PGSIZE);
+    return (char*)r;
+  }
+  pgstat.type[V2P(r) / PGSIZE] = type;
+  if(type != PG_KERNEL)
+    xadd(&pgstat.npages[type], 1);
+  return (char*)r;
+}
+
+// scheduler에서 실행할 process가 없을 때 호출
+// kzero pool이 KZERO_MAX보다 적으면 최대 KZERO_IDLE개의 page를 0으로 채워 추가
+void
+kzero_idle(void)
+{
+  struct run *r;
+  int i;
+
+  // startothers에서 시작한 CPU는 kinit2가 끝나기 전에도 scheduler에 들어오므로, 그 동안은 lock 없는 freelist를 건드리지 않음
+  if(!kmem.use_lock)
+    return;
+  // 자신의 cache와 전역 freelist에 남은 page만 사용 (다른 CPU의 cache를 가져오거나 hugepage 영역을 나누지 않음)
+  for(i = 0; i < KZERO_IDLE && kzero.nfree < KZERO_MAX; i++){
+    if((r = kcache_pop()) == 0)
+      break;
+    refc.refc_arr[V2P(r) / PGSIZE] = 1;
+    pgstat.type[V2P(r) / PGSIZE] = PG_KERNEL;
+    memset(r, 0, PGSIZE);
+    acquire(&kzero.lock);
+    r->next = kzero.freelist;
+    kzero.freelist = r;
+    kzero.nfree++;
+    release(&kzero.lock);
+  }
+}
+
+// 연속된 4MB physical memory를 할당하여 user hugepage로 기록
+// 참조 횟수는 첫 번째 page에만 유지하며, 남은 hugepage가 없으면 0을 반환
+char*
+kalloc_huge(void)
+{
+  struct run *r;
+  uint pa;
 
+  if((r = khuge_pop()) == 0)
+    return 0;
+  pa = V2P(r);
+  refc.refc_arr[pa / PGSIZE] = 1;
+  for(int i = 0; i < NPTENTRIES; i++)
+    pgstat.type[pa / PGSIZE + i] = PG_USER;
+  xadd(&pgstat.npages[PG_USER], NPTENTRIES);
   return (char*)r;
 }
 
+// kalloc_huge로 할당한 4MB 영역을 다시 hugepage용으로 돌려놓음
+void
+kfree_huge(char *v)
+{
+  struct run *r = (struct run*)v;
+
+  if((uint)v % HUGEPGSIZE || v < end || V2P(v) >= PHYSTOP)
+    panic("kfree_huge");
+  if(decr_refc(V2P(v)) > 0)
+    panic("kfree_huge: shared");
+  for(int i = 0; i < NPTENTRIES; i++)
+    pgstat.type[V2P(v) / PGSIZE + i] = PG_KERNEL;
+  xadd(&pgstat.npages[PG_USER], -NPTENTRIES);
+
+  acquire(&khuge.lock);
+  r->next = khuge.freelist;
+  khuge.freelist = r;
+  khuge.nfree++;
+  release(&khuge.lock);
+}
+
+// hugepage를 4KB page들로 나누어 mapping하기 전에 호출
+// 이후 각 page는 일반 user page처럼 각자의 참조 횟수를 가지고 kfree로 하나씩 free됨
+void
+ksplit_huge(char *v)
+{
+  uint pa = V2P(v);
+
+  if((uint)v % HUGEPGSIZE || get_refc(pa) != 1)
+    panic("ksplit_huge");
+  for(int i = 1; i < NPTENTRIES; i++)
+    refc.refc_arr[pa / PGSIZE + i] = 1;
+}
+
 void 
 incr_refc(uint pa)
 {
-  if(refc.use_lock)
-    acquire(&refc.lock);
-  
-  refc.refc_arr[pa / PGSIZE]++;
-  
-  if(refc.use_lock)
-    release(&refc.lock);
+  if(xadd(&refc.refc_arr[pa / PGSIZE], 1) == 1) // 처음으로 공유되는 page
+    xadd(&refc.nshared, 1);
 }
 
-void 
+// 참조 횟수를 1 감소시키고 감소된 후의 참조 횟수를 반환
+int 
 decr_refc(uint pa)
 {
-  if(refc.use_lock)
-    acquire(&refc.lock);
-  
-  refc.refc_arr[pa / PGSIZE]--;
-  
-  if(refc.use_lock)
-    release(&refc.lock);
+  uint old = xadd(&refc.refc_arr[pa / PGSIZE], -1);
+
+  if(old == 0)
+    panic("decr_refc");
+  if(old == 2) // 더 이상 공유되지 않는 page
+    xadd(&refc.nshared, -1);
+
+  return old - 1;
 }
 
 int 
 get_refc(uint pa)
 {
-  if(refc.use_lock)
-    acquire(&refc.lock);
-  
-  int refc_ = refc.refc_arr[pa / PGSIZE];
-  
-  if(refc.use_lock)
-    release(&refc.lock);
-
-  return refc_;
+  return refc.refc_arr[pa / PGSIZE];
 }
 
+// freelist를 순회하지 않고 전역 freelist와 per-CPU cache의 page 수를 더해서 반환
+// 다른 CPU의 allocator를 멈추지 않도록 lock을 잡지 않음
 int 
 countfp(void)
 {
-  int count = 0;
-  if(kmem.use_lock)
-    acquire(&kmem.lock);
+  int count = kmem.nfree;
 
-  for(struct run *fp = kmem.freelist; fp != 0; fp = fp->next){
-    count++;
-  }
-  
-  if(kmem.use_lock)
-    release(&kmem.lock);
+  for(int i = 0; i < NCPU; i++)  // 각 CPU의 cache에 남아있는 free page도 count
+    count += kcache[i].nfree;
+  count += khuge.nfree * NPTENTRIES; // hugepage용으로 떼어둔 영역도 free page로 count
+  count += kzero.nfree;              // 0으로 채워둔 page도 바로 할당할 수 있으므로 count
 
   return count;
 }
+
+void
+getmemstat(struct memstat *ms)
+{
+  ms->free = countfp();
+  ms->shared = refc.nshared;
+  ms->pgtab = pgstat.npages[PG_PGTAB];
+  ms->kstack = pgstat.npages[PG_KSTACK];
+  ms->user = pgstat.npages[PG_USER];
+  ms->cowaround = cowaround;
+  ms->hugefree = khuge.nfree;
+  ms->slab = pgstat.npages[PG_SLAB];
+  ms->zeropool = kzero.nfree;
+  ms->zeromiss = kzero.miss;
+  getksmstat(ms);
+  getswapstat(ms);
+  getbcachestat(ms);
+}
@@ -0,0 +1,61 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define PGSIZE     4096
+#define NPAGES     64   // child가 write하는 page 수 (page마다 CoW fault로 kalloc 1번)
+#define ROUNDS     20   // worker 하나가 반복하는 fork 횟수
+#define MAXWORKER  8
+
+char *buf;
+
+// fork 후 child가 buf의 모든 page에 write하여 kalloc/kfree를 반복적으로 유발
+void
+worker(void)
+{
+  int pid;
+
+  for(int r = 0; r < ROUNDS; r++){
+    pid = fork();
+    if(pid < 0){
+      printf(1, "fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      for(int i = 0; i < NPAGES; i++)
+        buf[i * PGSIZE] = i;
+      exit();
+    }
+    wait();
+  }
+  exit();
+}
+
+int
+main(int argc, char *argv[])
+{
+  int start, elapsed, pages;
+
+  printf(1, "[kalloc bench] fork+touch, %d pages x %d rounds per worker\n", NPAGES, ROUNDS);
+
+  buf = sbrk(NPAGES * PGSIZE);
+  memset(buf, 0, NPAGES * PGSIZE);
+
+  for(int n = 1; n <= MAXWORKER; n++){
+    start = uptime();
+    for(int w = 0; w < n; w++){
+      if(fork() == 0)
+        worker();
+    }
+    for(int w = 0; w < n; w++)
+      wait();
+    elapsed = uptime() - start;
+
+    pages = n * ROUNDS * NPAGES;
+    if(elapsed == 0)
+      elapsed = 1;
+    printf(1, "workers %d: %d pages in %d ticks (%d pages/tick)\n", n, pages, elapsed, pages / elapsed);
+  }
+
+  exit();
+}
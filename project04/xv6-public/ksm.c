@@ -0,0 +1,137 @@
+// Kernel same-page merging
+// ksm(1)을 호출한 process의 anonymous page를 ksmd가 백그라운드에서 hash하여, 내용이 같은 page를 찾으면
+// 하나의 read-only page로 합치고 나머지 page를 free함
+// 합친 page는 fork 이후의 CoW page와 같이 참조 횟수(refc_arr)로 공유되며, write하면 CoW_handler에서 복사됨
+// 모두 0인 page는 zero page로 합침
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "memstat.h"
+
+#define KSMHASH      4096  // 합칠 후보 page를 기록하는 hash table 크기
+#define KSMBATCH     128   // ksmd가 tick마다 확인하는 page 수
+
+extern char *zeropage; // vm.c
+
+// hash 값마다 마지막으로 본 page 하나를 기록 (직접 사상 방식이므로 충돌하면 덮어씀)
+struct ksment {
+  uint hash;
+  struct proc *p;   // page를 mapping한 process (0이면 빈 항목)
+  int pid;          // p가 재사용되었는지 확인
+  uint va;
+  uint pa;
+};
+
+// ksmd만 접근하므로 lock이 필요 X
+struct {
+  struct ksment tab[KSMHASH];
+  uint zerohash;     // 0으로 채워진 page의 hash
+  uint scanned;      // hash한 page 수
+  uint merged;       // 합쳐서 free한 page 수
+  uint kcycles;      // ksmd가 scan에 사용한 CPU cycle (1024 cycle 단위)
+} ksm;
+
+static uint
+pagehash(char *mem)
+{
+  uint *w = (uint*)mem, h = 2166136261;  // FNV-1a
+  int i;
+
+  for(i = 0; i < PGSIZE/sizeof(uint); i++)
+    h = (h ^ w[i]) * 16777619;
+  return h;
+}
+
+// pte가 가리키던 page를 pa로 바꾸고 기존 page를 free (pa는 이미 다른 page table이 read-only로 mapping)
+static void
+merge(struct proc *p, pte_t *pte, uint pa)
+{
+  char *old = P2V(PTE_ADDR(*pte));
+
+  incr_refc(pa);
+  *pte = pa | PTE_P | PTE_U;
+  kfree(old);
+  p->cowpg++;
+  ksm.merged++;
+}
+
+// ksm_scan에서 ptable.lock을 잡고 호출하며, p는 다른 CPU에서 실행 중이 아니고 자신의 PTE를 바꾸는 중(ptbusy)도 아님
+// p의 va에 mapping된 writable private page를 hash하여, 같은 hash로 기록된 page와 내용이 같으면 합침
+void
+ksm_page(struct proc *p, uint va)
+{
+  struct ksment *e;
+  pte_t *pte, *tpte;
+  char *mem;
+  uint h, pa;
+
+  if((pte = privpte(p->pgdir, va)) == 0)
+    return;
+  if((*pte & (PTE_P|PTE_U|PTE_W)) != (PTE_P|PTE_U|PTE_W) || (*pte & PTE_SHARED))
+    return;
+  pa = PTE_ADDR(*pte);
+  if(get_refc(pa) != 1)
+    return;
+  mem = P2V(pa);
+  h = pagehash(mem);
+  ksm.scanned++;
+
+  if(h == ksm.zerohash && memcmp(mem, zeropage, PGSIZE) == 0){
+    merge(p, pte, V2P(zeropage));
+    return;
+  }
+
+  e = &ksm.tab[h % KSMHASH];
+  // 기록된 page가 아직 같은 process의 같은 주소에 mapping되어 있고, 그 process도 실행 중이거나 PTE를 바꾸는 중이 아닐 때만 합침
+  if(e->p && e->hash == h && e->pa != pa && e->p->pid == e->pid && e->p->ksm && !e->p->ptbusy &&
+     (e->p->state == RUNNABLE || e->p->state == SLEEPING) &&
+     (tpte = privpte(e->p->pgdir, e->va)) != 0 && (*tpte & PTE_P) && PTE_ADDR(*tpte) == e->pa &&
+     memcmp(mem, P2V(e->pa), PGSIZE) == 0){
+    *tpte &= ~PTE_W; // 기록된 page도 read-only로 바꾸어 이후 write는 CoW로 처리
+    e->p->cowpg++;
+    merge(p, pte, e->pa);
+    return;
+  }
+  e->hash = h;
+  e->p = p;
+  e->pid = p->pid;
+  e->va = va;
+  e->pa = pa;
+}
+
+static void
+ksmd(void)
+{
+  unsigned long long t;
+
+  for(;;){
+    acquire(&tickslock);
+    sleep(&ticks, &tickslock);
+    release(&tickslock);
+
+    t = rdtsc();
+    ksm_scan(KSMBATCH);
+    ksm.kcycles += (rdtsc() - t) >> 10;
+  }
+}
+
+void
+ksminit(void)
+{
+  ksm.zerohash = pagehash(zeropage);
+  kthread("ksmd", ksmd);
+}
+
+void
+getksmstat(struct memstat *ms)
+{
+  ms->ksmscanned = ksm.scanned;
+  ms->ksmmerged = ksm.merged;
+  ms->ksmkcycles = ksm.kcycles;
+}
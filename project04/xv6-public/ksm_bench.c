@@ -0,0 +1,86 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "memstat.h"
+
+#define PGSIZE    4096
+#define NCHILD    4
+#define NPG       256   // child 하나가 채우는 page 수
+#define NPATTERN  16    // 서로 다른 page 내용의 수
+#define WAIT      500   // child가 page를 채운 뒤 ksmd를 기다리는 tick
+
+// i번째 page를 채울 내용 (모든 child가 같은 내용을 write)
+uint
+word(int i, int j)
+{
+  return (i % NPATTERN) * 4099 + j;
+}
+
+int
+verify(uint *p)
+{
+  for(int i = 0; i < NPG; i++)
+    for(int j = 0; j < PGSIZE/4; j++)
+      if(p[i*PGSIZE/4 + j] != word(i, j))
+        return -1;
+  return 0;
+}
+
+void
+child(void)
+{
+  uint *p;
+
+  if((p = (uint*)sbrk(NPG * PGSIZE)) == (uint*)-1){
+    printf(1, "sbrk failed\n");
+    exit();
+  }
+  for(int i = 0; i < NPG; i++)
+    for(int j = 0; j < PGSIZE/4; j++)
+      p[i*PGSIZE/4 + j] = word(i, j);
+  sleep(WAIT);
+
+  // 합쳐진 page의 내용을 확인하고, 다시 write하면 CoW로 각자의 page를 가져야 함
+  if(verify(p) < 0)
+    printf(1, "ksm bench: corrupted after merge\n");
+  for(int i = 0; i < NPG; i++)
+    p[i*PGSIZE/4] = word(i, 0);
+  if(verify(p) < 0)
+    printf(1, "ksm bench: corrupted after CoW\n");
+  exit();
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct memstat base, ms;
+
+  printf(1, "[ksm bench] %d processes x %d pages, %d distinct pages\n", NCHILD, NPG, NPATTERN);
+  ksm(1); // fork한 child도 ksm이 켜진 상태로 시작
+  for(int i = 0; i < NCHILD; i++){
+    int pid = fork();
+    if(pid < 0){
+      printf(1, "fork failed\n");
+      exit();
+    }
+    if(pid == 0)
+      child();
+  }
+  sleep(20); // child들이 page를 모두 채울 때까지 대기
+  memstat(&base);
+
+  for(int t = 100; t < WAIT; t += 100){
+    sleep(100);
+    memstat(&ms);
+    printf(1, "%d ticks: reclaimed %d pages (merged %d, scanned %d)\n", t,
+           ms.free - base.free, ms.ksmmerged - base.ksmmerged, ms.ksmscanned - base.ksmscanned);
+  }
+  if(ms.ksmscanned > base.ksmscanned)
+    printf(1, "scanner cost: %d cycles per page\n",
+           (ms.ksmkcycles - base.ksmkcycles) * 1024 / (ms.ksmscanned - base.ksmscanned));
+
+  for(int i = 0; i < NCHILD; i++)
+    wait();
+  printf(1, "[ksm bench] done\n");
+  exit();
+}
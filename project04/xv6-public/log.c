@@ -9,7 +9,7 @@
 // Simple logging that allows concurrent FS system calls.
 //
 // A log transaction contains the updates of multiple FS system
-// calls. The logging system only commits when there are
+// calls. The logging system only closes a transaction when there are
 // no FS system calls active. Thus there is never
 // any reasoning required about whether a commit might
 // write an uncommitted system call's updates to disk.
@@ -18,7 +18,11 @@
 // its start and end. Usually begin_op() just increments
 // the count of in-progress FS system calls and returns.
 // But if it thinks the log is close to running out, it
-// sleeps until the last outstanding end_op() commits.
+// commits the current transaction first.
+//
+// transaction은 logflush가 commit interval마다 commit하며(group commit), fsync를 호출하지 않는
+// system call은 disk write를 기다리지 않고 return함
+// commit은 transaction을 닫을 때 block을 log buffer에 복사해 두므로, 그 내용을 disk에 쓰는 동안 다음 transaction이 채워짐
 //
 // The log is a physical re-do log containing disk blocks.
 // The on-disk log format:
@@ -28,6 +32,11 @@
 //   block C
 //   ...
 // Log appends are synchronous.
+//
+// commit은 header를 쓴 시점(commit point)에서 끝나고, transaction의 block을
+// home location에 쓰는 checkpoint는 logflush kernel thread가 나중에 수행
+// checkpoint가 끝날 때까지 on-disk header를 지우지 않으므로 그 전에 crash가 나도 recovery에서 다시 install됨
+// 다음 commit은 log 영역을 덮어쓰기 전에 이전 transaction의 checkpoint가 끝나기를 기다리거나 직접 수행
 
 // Contents of the header block, used for both the on-disk header block
 // and to keep track in memory of logged block# before commit.
@@ -41,14 +50,27 @@ struct log {
   int start;
   int size;
   int outstanding; // how many FS sys calls are executing.
-  int committing;  // in commit(), please wait.
+  int committing;  // commit()이 transaction을 닫는 중, please wait.
   int dev;
   struct logheader lh;
+  struct logheader ct; // commit 중인 transaction (log와 header를 disk에 쓰는 중)
+  struct sleeplock commitlock; // 한 번에 하나의 commit만 진행
+  uint lhtime;         // lh에 첫 block이 기록된 tick
+  int interval;        // commit interval (tick), 0이면 매 end_op에서 commit
+  struct logheader ck; // commit했지만 아직 home location에 쓰지 않은 transaction
+  int ckstate;         // CK_NONE, CK_PENDING, CK_RUNNING
+  uint cktime;         // ck를 commit한 tick
+  struct buf wbuf;     // checkpoint에서 log block을 home location에 쓰는 buffer (buffer cache를 거치지 않음)
 };
 struct log log;
 
+#define CK_NONE     0
+#define CK_PENDING  1
+#define CK_RUNNING  2
+
 static void recover_from_log(void);
 static void commit();
+static void logflush(void);
 
 void
 initlog(int dev)
@@ -62,22 +84,52 @@ initlog(int dev)
   log.start = sb.logstart;
   log.size = sb.nlog;
   log.dev = dev;
+  initsleeplock(&log.wbuf.lock, "logwbuf");
+  initsleeplock(&log.commitlock, "logcommit");
+  log.interval = COMMITIVL;
   recover_from_log();
+  kthread("logflush", logflush);
 }
 
 // Copy committed blocks from log to their home location
+// log block의 내용을 log.wbuf로 직접 쓰므로, 그 사이 현재 transaction이 같은 block을 다시 수정했더라도
+// commit하지 않은 내용이 home location에 쓰이지 않음 (cache의 block은 항상 최신 내용을 유지)
 static void
 install_trans(void)
 {
   int tail;
 
-  for (tail = 0; tail < log.lh.n; tail++) {
+  acquiresleep(&log.wbuf.lock);
+  for (tail = 0; tail < log.ck.n; tail++) {
     struct buf *lbuf = bread(log.dev, log.start+tail+1); // read log block
-    struct buf *dbuf = bread(log.dev, log.lh.block[tail]); // read dst
-    memmove(dbuf->data, lbuf->data, BSIZE);  // copy block to dst
-    bwrite(dbuf);  // write dst to disk
+    memmove(log.wbuf.data, lbuf->data, BSIZE);
     brelse(lbuf);
-    brelse(dbuf);
+    log.wbuf.dev = log.dev;
+    log.wbuf.blockno = log.ck.block[tail];
+    log.wbuf.flags = B_DIRTY;
+    iderw(&log.wbuf);  // write dst to disk
+  }
+  releasesleep(&log.wbuf.lock);
+}
+
+// home location에 쓴 block의 pin(B_DIRTY)을 풀어 buffer cache에서 evict될 수 있게 함
+// 현재 transaction이 다시 수정한 block은 그 transaction의 commit까지 pin된 상태로 둠
+static void
+unpin_trans(void)
+{
+  int tail, i;
+  struct buf *b;
+
+  for (tail = 0; tail < log.ck.n; tail++) {
+    b = bread(log.dev, log.ck.block[tail]); // pin되어 있으므로 cache에 있음
+    acquire(&log.lock);
+    for (i = 0; i < log.lh.n; i++)
+      if (log.lh.block[i] == b->blockno)
+        break;
+    if (i == log.lh.n)
+      b->flags &= ~B_DIRTY;
+    release(&log.lock);
+    brelse(b);
   }
 }
 
@@ -88,9 +140,9 @@ read_head(void)
   struct buf *buf = bread(log.dev, log.start);
   struct logheader *lh = (struct logheader *) (buf->data);
   int i;
-  log.lh.n = lh->n;
-  for (i = 0; i < log.lh.n; i++) {
-    log.lh.block[i] = lh->block[i];
+  log.ck.n = lh->n;
+  for (i = 0; i < log.ck.n; i++) {
+    log.ck.block[i] = lh->block[i];
   }
   brelse(buf);
 }
@@ -99,26 +151,80 @@ read_head(void)
 // This is the true point at which the
 // current transaction commits.
 static void
-write_head(void)
+write_head(struct logheader *lh)
 {
   struct buf *buf = bread(log.dev, log.start);
   struct logheader *hb = (struct logheader *) (buf->data);
   int i;
-  hb->n = log.lh.n;
-  for (i = 0; i < log.lh.n; i++) {
-    hb->block[i] = log.lh.block[i];
+  hb->n = lh->n;
+  for (i = 0; i < lh->n; i++) {
+    hb->block[i] = lh->block[i];
   }
   bwrite(buf);
   brelse(buf);
 }
 
+// commit한 transaction(log.ck)을 home location에 쓰고 log를 비움
+static void
+checkpoint(void)
+{
+  install_trans();
+  unpin_trans();
+  log.ck.n = 0;
+  write_head(&log.ck); // Erase the transaction from the log
+}
+
 static void
 recover_from_log(void)
 {
   read_head();
-  install_trans(); // if committed, copy from log to disk
-  log.lh.n = 0;
-  write_head(); // clear the log
+  checkpoint(); // if committed, copy from log to disk
+}
+
+// 기다리는 checkpoint가 있으면 수행
+// force가 0이면 commit한 지 CKPTAGE tick이 지난 경우에만 수행하고,
+// 1이면(log 영역이 필요한 commit) 바로 수행하며 다른 thread가 수행 중이면 끝날 때까지 기다림
+static void
+try_checkpoint(int force)
+{
+  acquire(&log.lock);
+  while(force && log.ckstate == CK_RUNNING)
+    sleep(&log.ck, &log.lock);
+  if(log.ckstate != CK_PENDING || (!force && ticks - log.cktime < CKPTAGE)){
+    release(&log.lock);
+    return;
+  }
+  log.ckstate = CK_RUNNING;
+  release(&log.lock);
+
+  checkpoint();
+
+  acquire(&log.lock);
+  log.ckstate = CK_NONE;
+  wakeup(&log.ck);
+  release(&log.lock);
+}
+
+// log flusher
+// 매 tick마다 열린 지 commit interval이 지난 transaction을 commit하고,
+// commit한 지 CKPTAGE tick이 지난 transaction을 home location에 씀
+static void
+logflush(void)
+{
+  int due;
+
+  for(;;){
+    acquire(&tickslock);
+    sleep(&ticks, &tickslock);
+    release(&tickslock);
+
+    acquire(&log.lock);
+    due = log.lh.n > 0 && ticks - log.lhtime >= log.interval;
+    release(&log.lock);
+    if(due)
+      commit();
+    try_checkpoint(0);
+  }
 }
 
 // called at the start of each FS system call.
@@ -130,8 +236,10 @@ begin_op(void)
     if(log.committing){
       sleep(&log, &log.lock);
     } else if(log.lh.n + (log.outstanding+1)*MAXOPBLOCKS > LOGSIZE){
-      // this op might exhaust log space; wait for commit.
-      sleep(&log, &log.lock);
+      // this op might exhaust log space; commit the current transaction.
+      release(&log.lock);
+      commit();
+      acquire(&log.lock);
     } else {
       log.outstanding += 1;
       release(&log.lock);
@@ -141,41 +249,31 @@ begin_op(void)
 }
 
 // called at the end of each FS system call.
-// commits if this was the last outstanding operation.
+// commit은 logflush가 commit interval마다 하거나, log 영역이 부족할 때 begin_op에서 함
+// 따라서 보통은 disk write 없이 바로 return하며, 변경 내용을 disk에 보장하려면 fsync를 호출해야 함
+// (interval이 0이면 예전처럼 매 end_op에서 commit)
 void
 end_op(void)
 {
-  int do_commit = 0;
+  int sync;
 
   acquire(&log.lock);
   log.outstanding -= 1;
-  if(log.committing)
-    panic("log.committing");
-  if(log.outstanding == 0){
-    do_commit = 1;
-    log.committing = 1;
-  } else {
-    // begin_op() may be waiting for log space,
-    // and decrementing log.outstanding has decreased
-    // the amount of reserved space.
-    wakeup(&log);
-  }
+  // commit() may be waiting for outstanding operations, and
+  // begin_op() may be waiting for log space.
+  wakeup(&log);
+  sync = log.interval == 0 && log.outstanding == 0;
   release(&log.lock);
 
-  if(do_commit){
-    // call commit w/o holding locks, since not allowed
-    // to sleep with locks.
+  if(sync)
     commit();
-    acquire(&log.lock);
-    log.committing = 0;
-    wakeup(&log);
-    release(&log.lock);
-  }
 }
 
-// Copy modified blocks from cache to log.
+// Copy modified blocks from cache to log buffers.
+// 진행 중인 FS system call이 없을 때 호출되므로 transaction의 내용만 복사됨
+// 복사한 log buffer는 lock을 잡은 채 lb에 저장하고, disk write는 write_log에서 함
 static void
-write_log(void)
+copy_log(struct buf **lb)
 {
   int tail;
 
@@ -183,27 +281,87 @@ write_log(void)
     struct buf *to = bread(log.dev, log.start+tail+1); // log block
     struct buf *from = bread(log.dev, log.lh.block[tail]); // cache block
     memmove(to->data, from->data, BSIZE);
-    bwrite(to);  // write the log
     brelse(from);
-    brelse(to);
+    lb[tail] = to;
   }
 }
 
+// Write the log.
+static void
+write_log(struct buf **lb, int n)
+{
+  int tail;
+
+  for (tail = 0; tail < n; tail++) {
+    bwrite(lb[tail]);
+    brelse(lb[tail]);
+  }
+}
+
+// 현재 transaction을 commit하고, 그때까지 끝난 FS system call의 변경 내용이 disk에 기록되면 return
+// 새로운 FS system call은 transaction을 닫는 동안(log.committing)만 기다리고,
+// log와 header를 disk에 쓰는 동안에는 다음 transaction을 채움 (commitlock이 한 번에 하나의 commit만 허용)
 static void
 commit()
 {
-  if (log.lh.n > 0) {
-    write_log();     // Write modified blocks from cache to log
-    write_head();    // Write header to disk -- the real commit
-    install_trans(); // Now install writes to home locations
-    log.lh.n = 0;
-    write_head();    // Erase the transaction from the log
+  static struct buf *lb[LOGSIZE];
+  struct logheader *ct = &log.ct;
+
+  acquiresleep(&log.commitlock);
+  try_checkpoint(1); // 이전 transaction이 아직 log 영역을 사용 중이면 먼저 home location에 씀
+
+  acquire(&log.lock);
+  log.committing = 1;
+  while(log.outstanding > 0)
+    sleep(&log, &log.lock);
+  release(&log.lock);
+
+  copy_log(lb);
+
+  acquire(&log.lock);
+  *ct = log.lh;
+  log.lh.n = 0;
+  log.committing = 0;
+  wakeup(&log);
+  release(&log.lock);
+
+  if (ct->n > 0) {
+    write_log(lb, ct->n); // Write modified blocks to log
+    write_head(ct);       // Write header to disk -- the real commit
+    acquire(&log.lock);
+    log.ck = *ct;         // home location에는 logflush가 씀
+    log.ckstate = CK_PENDING;
+    log.cktime = ticks;
+    release(&log.lock);
   }
+  releasesleep(&log.commitlock);
+}
+
+// fsync에서 호출
+// 이미 끝난 FS system call의 변경 내용을 disk에 기록 (log가 하나이므로 file과 관계없이 모든 변경 내용을 commit)
+void
+log_sync(void)
+{
+  commit();
+}
+
+// commit interval을 tick 단위로 설정하고 이전 값을 반환 (음수면 바꾸지 않음)
+int
+log_interval(int interval)
+{
+  int old;
+
+  acquire(&log.lock);
+  old = log.interval;
+  if(interval >= 0)
+    log.interval = interval;
+  release(&log.lock);
+  return old;
 }
 
 // Caller has modified b->data and is done with the buffer.
 // Record the block number and pin in the cache with B_DIRTY.
-// commit()/write_log() will do the disk write.
+// commit()/copy_log()/write_log() will do the disk write.
 //
 // log_write() replaces bwrite(); a typical use is:
 //   bp = bread(...)
@@ -225,6 +383,8 @@ log_write(struct buf *b)
     if (log.lh.block[i] == b->blockno)   // log absorbtion
       break;
   }
+  if (log.lh.n == 0)
+    log.lhtime = ticks;
   log.lh.block[i] = b->blockno;
   if (i == log.lh.n)
     log.lh.n++;
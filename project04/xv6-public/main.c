@@ -27,13 +27,20 @@ main(void)
   consoleinit();   // console hardware
   uartinit();      // serial port
   pinit();         // process table
+  shminit();       // shared memory segments
+  execinit();      // program page cache
+  mmapinit();      // shared file mapping page cache
   tvinit();        // trap vectors
-  binit();         // buffer cache
+  slabinit();      // slab allocator
   fileinit();      // file table
+  binit();         // buffer cache
+  pipeinit();      // pipe object cache
   ideinit();       // disk 
   startothers();   // start other processors
   kinit2(P2V(4*1024*1024), P2V(PHYSTOP)); // must come after startothers()
   userinit();      // first user process
+  swapinit();      // swap daemon
+  ksminit();       // same-page merging daemon
   mpmain();        // finish this processor's setup
 }
 
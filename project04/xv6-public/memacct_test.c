@@ -0,0 +1,114 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "memstat.h"
+
+#define PGSIZE  4096
+#define NPG     128   // sbrk로 늘려서 접근하는 page 수
+#define LIMIT   32    // limit test에서 child가 더 사용할 수 있는 page 수
+#define NCALL   10000 // procmem 호출 횟수
+
+int failed;
+struct procmem gpm; // bss에 있는 target
+
+void
+check(int ok, char *msg)
+{
+  if(!ok){
+    printf(1, "FAIL: %s\n", msg);
+    failed = 1;
+  }
+}
+
+void
+touch(char *p, int npg)
+{
+  for(int i = 0; i < npg; i++)
+    p[i * PGSIZE] = 1;
+}
+
+// 다른 process(parent)가 procmem으로 확인하는 동안 pipe로 순서를 맞춤
+void
+waitfor(int fd)
+{
+  char c;
+
+  if(read(fd, &c, 1) != 1)
+    exit();
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct procmem before, after, pm, *fresh;
+  int tochild[2], toparent[2], pid, start;
+  char *p, c = 0;
+
+  printf(1, "[memacct test]\n");
+
+  // 자신의 counter: page table을 순회하던 countpp와 같은 값이어야 함
+  check(procmem(getpid(), &before) == 0, "procmem self");
+  check(before.rss == countpp() && before.pgtab == countptp(), "counter matches countpp/countptp");
+  p = sbrk(NPG * PGSIZE);
+  touch(p, NPG);
+  procmem(getpid(), &after);
+  check(after.rss - before.rss == NPG, "rss grows by touched pages");
+  check(after.maxrss >= after.rss, "maxrss");
+  printf(1, "self: rss %d -> %d, pgtab %d, maxrss %d\n", before.rss, after.rss, after.pgtab, after.maxrss);
+
+  // fork한 child의 counter를 parent가 확인: 처음에는 모든 page가 CoW로 공유되고, write하면 혼자 사용하게 됨
+  pipe(tochild);
+  pipe(toparent);
+  if((pid = fork()) == 0){
+    touch(p, 0);
+    write(toparent[1], &c, 1);
+    waitfor(tochild[0]);
+    touch(p, NPG);
+    write(toparent[1], &c, 1);
+    waitfor(tochild[0]);
+    exit();
+  }
+  waitfor(toparent[0]);
+  procmem(pid, &pm);
+  printf(1, "child after fork: rss %d, cow %d\n", pm.rss, pm.cow);
+  check(pm.rss == after.rss && pm.cow >= NPG, "child shares parent pages");
+  write(tochild[1], &c, 1);
+  waitfor(toparent[0]);
+  procmem(pid, &pm);
+  printf(1, "child after write: rss %d, cow %d\n", pm.rss, pm.cow);
+  check(pm.rss == after.rss && pm.cow <= after.rss - NPG, "child copied written pages");
+  write(tochild[1], &c, 1);
+  wait();
+  check(procmem(pid, &pm) < 0, "procmem on exited pid");
+
+  // limit: child가 limit을 넘는 page를 할당하면 kill되어야 함
+  if((pid = fork()) == 0){
+    waitfor(tochild[0]);
+    p = sbrk(2 * LIMIT * PGSIZE);
+    touch(p, 2 * LIMIT);
+    write(toparent[1], &c, 1); // limit이 적용되지 않았을 때만 도달
+    exit();
+  }
+  procmem(pid, &pm);
+  check(memlimit(pid, pm.rss - pm.cow - pm.shared + LIMIT) == 0, "memlimit");
+  procmem(pid, &pm);
+  write(tochild[1], &c, 1);
+  close(toparent[1]);
+  check(read(toparent[0], &c, 1) == 0, "child over limit was not killed");
+  wait();
+  printf(1, "child with limit %d pages: killed\n", pm.limit);
+
+  // user memory의 target이 아직 mapping되지 않은 page여도 kernel이 page fault를 처리하고 복사해야 함
+  check(procmem(getpid(), &gpm) == 0 && gpm.rss > 0, "procmem into bss");
+  fresh = (struct procmem*)sbrk(PGSIZE);
+  check(procmem(getpid(), fresh) == 0 && fresh->rss > 0, "procmem into fresh sbrk page");
+
+  start = uptime();
+  for(int i = 0; i < NCALL; i++)
+    procmem(getpid(), &pm);
+  printf(1, "%d procmem calls: %d ticks\n", NCALL, uptime() - start);
+
+  if(!failed)
+    printf(1, "OK\n");
+  exit();
+}
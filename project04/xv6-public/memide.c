@@ -58,3 +58,11 @@ iderw(struct buf *b)
     memmove(b->data, p, BSIZE);
   b->flags |= B_VALID;
 }
+
+// memory disk는 바로 읽을 수 있으므로 읽은 뒤 buffer를 놓음
+void
+iderwasync(struct buf *b)
+{
+  iderw(b);
+  bdone(b);
+}
@@ -0,0 +1,35 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "memstat.h"
+
+// physical page 사용 현황 출력
+// memstat [n] : n tick 간격으로 계속 출력
+int
+main(int argc, char *argv[])
+{
+  struct memstat ms;
+  int interval = 0;
+
+  if(argc > 1)
+    interval = atoi(argv[1]);
+
+  for(;;){
+    if(memstat(&ms) < 0){
+      printf(2, "memstat failed\n");
+      exit();
+    }
+    printf(1, "free %d shared %d pgtab %d kstack %d user %d cowaround %d hugefree %d swapout %d swapin %d swapsize %d slab %d\n"
+           "zeropool %d zeromiss %d ksmscanned %d ksmmerged %d ksmkcycles %d\n"
+           "bcachebuf %d bcachehit %d bcachemiss %d bcacheahead %d\n",
+           ms.free, ms.shared, ms.pgtab, ms.kstack, ms.user, ms.cowaround, ms.hugefree,
+           ms.swapout, ms.swapin, ms.swapsize, ms.slab, ms.zeropool, ms.zeromiss,
+           ms.ksmscanned, ms.ksmmerged, ms.ksmkcycles,
+           ms.bcachebuf, ms.bcachehit, ms.bcachemiss, ms.bcacheahead);
+    if(interval <= 0)
+      break;
+    sleep(interval);
+  }
+
+  exit();
+}
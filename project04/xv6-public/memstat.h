@@ -0,0 +1,41 @@
+// kalloc_type()에 전달하는 page 용도
+#define PG_KERNEL  0   // 그 외 kernel이 사용하는 page (pipe, ...)
+#define PG_PGTAB   1   // page directory, page table
+#define PG_KSTACK  2   // kernel stack
+#define PG_USER    3   // user memory
+#define PG_SLAB    4   // slab allocator가 작은 kernel object를 담는 page
+#define NPGTYPE    5
+
+// memstat system call이 반환하는 physical page 사용 현황
+struct memstat {
+  uint free;    // free page 수
+  uint shared;  // 2개 이상의 page table이 공유하는 page 수 (refc > 1)
+  uint pgtab;   // page directory, page table로 사용 중인 page 수
+  uint kstack;  // kernel stack으로 사용 중인 page 수
+  uint user;    // user memory로 사용 중인 page 수
+  uint cowaround;  // CoW fault-around으로 미리 복사하여 발생하지 않은 page fault 수
+  uint hugefree;   // 할당할 수 있는 4MB hugepage 수
+  uint swapout;    // swap 영역으로 내보낸 page 수
+  uint swapin;     // swap 영역에서 다시 읽어온 page 수
+  uint swapsize;   // swap 영역의 page 수
+  uint slab;       // slab allocator가 사용 중인 page 수
+  uint zeropool;   // 미리 0으로 채워둔 page 수
+  uint zeromiss;   // 0으로 채워둔 page가 없어 할당할 때 직접 0으로 채운 횟수
+  uint ksmscanned; // ksmd가 hash한 page 수
+  uint ksmmerged;  // ksmd가 같은 내용의 page를 합쳐 free한 page 수
+  uint ksmkcycles; // ksmd가 scan에 사용한 CPU cycle (1024 cycle 단위)
+  uint bcachebuf;  // buffer cache의 buffer 수
+  uint bcachehit;  // buffer cache에서 찾은 block 수
+  uint bcachemiss; // buffer cache에 없어 disk에서 읽은 block 수
+  uint bcacheahead; // readahead로 미리 읽은 block 수
+};
+
+// procmem system call이 반환하는 process 하나의 memory 사용량 (page 단위)
+struct procmem {
+  uint rss;     // mapping된 physical page 수
+  uint cow;     // 그 중 CoW로 공유하는 page 수
+  uint shared;  // 그 중 MAP_SHARED page 수
+  uint pgtab;   // page directory, page table page 수
+  uint maxrss;  // rss의 최댓값
+  uint limit;   // 혼자 사용하는 page 수(rss - cow - shared)의 상한, 0이면 제한 없음
+};
@@ -0,0 +1,84 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+
+#define NWRITER 8
+#define NFILE   32          // writer당 만들고 지우는 file 수
+
+// NWRITER개의 process가 동시에 빈 file을 만들고 지우는 metadata 작업의 처리량을 측정
+// commit interval이 0이면 매 end_op에서 commit하고, 아니면 logflush가 여러 system call을 모아 한 번에 commit함
+
+void
+name(char *path, int w, int i)
+{
+  strcpy(path, "mb000");
+  path[2] = '0' + w;
+  path[3] = '0' + i / 10;
+  path[4] = '0' + i % 10;
+}
+
+void
+work(int w)
+{
+  char path[8];
+  int fd;
+
+  for(int i = 0; i < NFILE; i++){
+    name(path, w, i);
+    if((fd = open(path, O_CREATE | O_RDWR)) < 0){
+      printf(1, "create %s failed\n", path);
+      exit();
+    }
+    close(fd);
+  }
+  for(int i = 0; i < NFILE; i++){
+    name(path, w, i);
+    if(unlink(path) < 0){
+      printf(1, "unlink %s failed\n", path);
+      exit();
+    }
+  }
+}
+
+// interval로 commit하면서 모든 writer가 끝날 때까지의 tick 수를 반환
+int
+run(int interval)
+{
+  int start, fd;
+
+  commitivl(interval);
+  start = uptime();
+  for(int w = 0; w < NWRITER; w++){
+    if(fork() == 0){
+      work(w);
+      exit();
+    }
+  }
+  for(int w = 0; w < NWRITER; w++)
+    wait();
+  fd = open(".", O_RDONLY);
+  fsync(fd); // 마지막 transaction까지 disk에 기록
+  close(fd);
+  return uptime() - start;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int def, interval, t;
+  int ops = NWRITER * NFILE * 2;
+
+  def = commitivl(-1);
+  printf(1, "[meta bench] %d writers x %d files, create + unlink\n", NWRITER, NFILE);
+
+  for(int r = 0; r < 2; r++){
+    interval = r == 0 ? 0 : def;
+    t = run(interval);
+    printf(1, "commit interval %d: %d ticks, %d ops/100 ticks\n", interval, t, t ? ops * 100 / t : 0);
+  }
+
+  commitivl(def);
+  printf(1, "OK\n");
+  exit();
+}
@@ -0,0 +1,11 @@
+// mmap의 prot (둘 중 하나 이상을 지정해야 하며, 접근할 수 없는 영역(PROT_NONE)은 지원하지 않음)
+#define PROT_READ     0x1
+#define PROT_WRITE    0x2
+
+// mmap의 flags (MAP_SHARED와 MAP_PRIVATE 중 하나를 지정)
+#define MAP_SHARED    0x01  // 변경 내용을 fork한 process, 같은 file을 mapping한 process, read/write와 공유
+                            // (file의 disk block에는 munmap, exit, exec에서 씀)
+#define MAP_PRIVATE   0x02  // 변경 내용을 혼자만 사용 (fork 후에는 CoW)
+#define MAP_ANONYMOUS 0x20  // file 없이 0으로 초기화된 memory
+
+#define MAP_FAILED    ((void*)-1)
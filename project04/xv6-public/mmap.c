@@ -0,0 +1,463 @@
+// mmap/munmap과 process의 가상 메모리 영역(VMA) 관리
+// mmap 영역은 [MMAPBASE, KERNBASE)에 만들어지며, page는 처음 접근할 때 vma_fault에서 할당 (demand paging)
+//
+// MAP_SHARED file mapping의 page는 (dev, inum, file offset)으로 mapcache에 보관하여 같은 file을 mapping한
+// 모든 process가 같은 page를 사용하고, readi와 writei도 이 page를 통해 읽고 써서 read/write와 store가 서로 보임
+// cache가 1개의 참조를 가지며, 더 이상 mapping한 process가 없으면(참조 횟수 1) munmap, exit, exec에서 버림
+// (page를 버리기 전에 vma_writeback으로 변경 내용을 file에 쓰므로 cache에 남은 page는 항상 file과 같음)
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "file.h"
+#include "stat.h"
+#include "mman.h"
+#include "memstat.h"
+
+struct {
+  struct spinlock lock;
+  struct {
+    uint dev;
+    uint inum;
+    uint off;     // page의 file offset
+    char *page;   // 0이면 빈 항목
+  } ent[NMAPPG];
+  int n;          // 사용 중인 항목 수, 0이면 readi와 writei가 cache를 확인하지 않음
+} mapcache;
+
+void
+mmapinit(void)
+{
+  initlock(&mapcache.lock, "mapcache");
+}
+
+// cache에 있는 page의 참조 횟수를 증가시켜 반환, 없으면 0을 반환
+static char*
+mapcache_get(uint dev, uint inum, uint off)
+{
+  char *page = 0;
+  int i;
+
+  acquire(&mapcache.lock);
+  for(i = 0; i < NMAPPG; i++){
+    if(mapcache.ent[i].page && mapcache.ent[i].dev == dev &&
+       mapcache.ent[i].inum == inum && mapcache.ent[i].off == off){
+      page = mapcache.ent[i].page;
+      incr_refc(V2P(page));
+      break;
+    }
+  }
+  release(&mapcache.lock);
+  return page;
+}
+
+// 더 이상 mapping한 process가 없는 page를 cache에서 버림
+static void
+mapcache_trim(void)
+{
+  int i;
+
+  acquire(&mapcache.lock);
+  for(i = 0; i < NMAPPG; i++){
+    if(mapcache.ent[i].page && get_refc(V2P(mapcache.ent[i].page)) == 1){
+      kfree(mapcache.ent[i].page);
+      mapcache.ent[i].page = 0;
+      mapcache.n--;
+    }
+  }
+  release(&mapcache.lock);
+}
+
+// file에서 읽어온 page를 cache에 추가, cache가 가득 찼으면 -1을 반환
+// inode lock을 잡은 상태에서 호출하므로 같은 page가 두 번 추가되지 않음
+static int
+mapcache_put(uint dev, uint inum, uint off, char *mem)
+{
+  int i;
+
+  acquire(&mapcache.lock);
+  for(i = 0; i < NMAPPG; i++)
+    if(mapcache.ent[i].page == 0)
+      break;
+  if(i == NMAPPG){
+    release(&mapcache.lock);
+    return -1;
+  }
+  mapcache.ent[i].dev = dev;
+  mapcache.ent[i].inum = inum;
+  mapcache.ent[i].off = off;
+  mapcache.ent[i].page = mem;
+  mapcache.n++;
+  incr_refc(V2P(mem)); // cache가 가진 참조
+  release(&mapcache.lock);
+  return 0;
+}
+
+// readi, writei에서 호출 (ip->lock을 잡은 상태)
+// [off, off+n) 중 cache에 있는 page는 disk block보다 최신이므로 buf로 다시 읽고(write가 0),
+// write한 내용은 cache의 page에도 써서 mapping한 process가 볼 수 있도록 함
+void
+mapcache_rw(struct inode *ip, char *buf, uint off, uint n, int write)
+{
+  uint a, s, e;
+  char *page;
+
+  if(mapcache.n == 0)
+    return;
+  for(a = PGROUNDDOWN(off); a < off + n; a += PGSIZE){
+    if((page = mapcache_get(ip->dev, ip->inum, a)) == 0)
+      continue;
+    s = a < off ? off : a;
+    e = a + PGSIZE > off + n ? off + n : a + PGSIZE;
+    if(write)
+      memmove(page + (s - a), buf + (s - off), e - s);
+    else
+      memmove(buf + (s - off), page + (s - a), e - s);
+    kfree(page); // mapcache_get으로 증가시킨 참조
+  }
+}
+
+// addr가 속한 VMA를 반환
+static struct vma*
+findvma(struct proc *p, uint addr)
+{
+  struct vma *v;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->addr && addr >= v->addr && addr < v->addr + v->len)
+      return v;
+  return 0;
+}
+
+// [MMAPBASE, KERNBASE)에서 다른 VMA와 겹치지 않는 len 크기 영역의 시작 주소를 찾음 (first fit)
+static uint
+findgap(struct proc *p, uint len)
+{
+  struct vma *v;
+  uint addr = MMAPBASE;
+  int moved;
+
+  do{
+    moved = 0;
+    for(v = p->vma; v < &p->vma[NVMA]; v++){
+      if(v->addr && addr < v->addr + v->len && v->addr < addr + len){
+        addr = v->addr + v->len;
+        moved = 1;
+      }
+    }
+  } while(moved);
+
+  if(addr + len < addr || addr + len > KERNBASE)
+    return 0;
+  return addr;
+}
+
+// VMA v에서 va가 속한 page를 할당하고 file 내용(anonymous면 0)으로 채워 mapping
+// MAP_SHARED file mapping은 다른 process와 같은 page를 사용하도록 mapcache에서 찾거나 추가
+static int
+vmapage(struct proc *p, struct vma *v, uint va)
+{
+  struct inode *ip;
+  char *mem = 0;
+  uint off;
+  int perm;
+
+  va = PGROUNDDOWN(va);
+  if(v->f){
+    ip = v->f->ip;
+    off = v->off + (va - v->addr);
+    ilock(ip);
+    if((v->flags & MAP_SHARED) && (mem = mapcache_get(ip->dev, ip->inum, off)) != 0){
+      iunlock(ip);
+    } else {
+      if((mem = kalloc_user(1)) == 0){
+        iunlock(ip);
+        return -1;
+      }
+      readi(ip, mem, off, PGSIZE); // file 끝을 넘는 부분은 0으로 남음
+      if((v->flags & MAP_SHARED) && mapcache_put(ip->dev, ip->inum, off, mem) < 0){
+        mapcache_trim(); // mapping이 없는 page를 버리고 다시 시도
+        if(mapcache_put(ip->dev, ip->inum, off, mem) < 0){
+          iunlock(ip);
+          kfree(mem);
+          return -1;
+        }
+      }
+      iunlock(ip);
+    }
+  } else if((mem = kalloc_user(1)) == 0)
+    return -1;
+
+  perm = PTE_U;
+  if(v->prot & PROT_WRITE)
+    perm |= PTE_W;
+  if(v->flags & MAP_SHARED)
+    perm |= PTE_SHARED;
+  if(mapuserpage(p->pgdir, va, mem, perm) < 0){
+    kfree(mem);
+    return -1;
+  }
+  return 0;
+}
+
+// MAP_SHARED file mapping에서 [addr, addr+len) 중 write된 page를 file에 반영
+// file 크기는 늘리지 않으며, filewrite처럼 log transaction 크기를 넘지 않도록 나누어 write
+static void
+vma_writeback(struct proc *p, struct vma *v, uint addr, uint len)
+{
+  int max = ((MAXOPBLOCKS-1-1-2) / 2) * 512;
+  struct inode *ip;
+  uint va, off, i, n;
+  char *ka;
+
+  if(v->f == 0 || !(v->flags & MAP_SHARED) || !(v->prot & PROT_WRITE))
+    return;
+  ip = v->f->ip;
+  for(va = addr; va < addr + len; va += PGSIZE){
+    if(!ptedirty(p->pgdir, (char*)va) || (ka = uva2ka(p->pgdir, (char*)va)) == 0)
+      continue;
+    off = v->off + (va - v->addr);
+    for(i = 0; i < PGSIZE; i += n){
+      n = PGSIZE - i;
+      if(n > max)
+        n = max;
+      begin_op();
+      ilock(ip);
+      if(off + i >= ip->size){
+        iunlock(ip);
+        end_op();
+        break;
+      }
+      if(n > ip->size - (off + i))
+        n = ip->size - (off + i);
+      writei(ip, ka + i, off + i, n);
+      iunlock(ip);
+      end_op();
+    }
+  }
+}
+
+// 새로운 VMA를 만들고 시작 주소를 반환, 실패하면 0을 반환
+// f는 MAP_ANONYMOUS가 아닐 때 mapping할 file
+uint
+mmap(uint len, int prot, int flags, struct file *f, uint off)
+{
+  struct proc *p = myproc();
+  struct vma *v;
+  uint addr;
+
+  if(len == 0 || off % PGSIZE != 0)
+    return 0;
+  if(!(prot & (PROT_READ|PROT_WRITE))) // 접근할 수 없는 영역(PROT_NONE)은 지원하지 않음
+    return 0;
+  if(!(flags & MAP_SHARED) == !(flags & MAP_PRIVATE)) // 둘 중 하나만 지정해야 함
+    return 0;
+  if(flags & MAP_ANONYMOUS){
+    f = 0;
+    off = 0;
+  } else {
+    if(f == 0 || f->type != FD_INODE || !f->readable || f->ip->type == T_DEV)
+      return 0;
+    if((flags & MAP_SHARED) && (prot & PROT_WRITE) && !f->writable)
+      return 0;
+  }
+
+  len = PGROUNDUP(len);
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->addr == 0)
+      break;
+  if(v == &p->vma[NVMA] || (addr = findgap(p, len)) == 0)
+    return 0;
+
+  v->addr = addr;
+  v->len = len;
+  v->prot = prot;
+  v->flags = flags;
+  v->f = f ? filedup(f) : 0;
+  v->off = off;
+  return addr;
+}
+
+// [addr, addr+len)의 mapping을 해제
+// 하나의 VMA 전체나 앞부분, 뒷부분만 해제할 수 있음 (가운데만 해제하여 VMA를 나누는 것은 지원하지 않음)
+int
+munmap(uint addr, uint len)
+{
+  struct proc *p = myproc();
+  struct vma *v;
+
+  len = PGROUNDUP(len);
+  if(addr % PGSIZE != 0 || len == 0 || (v = findvma(p, addr)) == 0)
+    return -1;
+  if(addr + len < addr || addr + len > v->addr + v->len)
+    return -1;
+  if(addr != v->addr && addr + len != v->addr + v->len)
+    return -1;
+
+  p->ptbusy++; // vma_writeback이 kernel 주소로 읽는 page를 swapd가 가져가지 않도록 함
+  vma_writeback(p, v, addr, len);
+  if(deallocuvm(p->pgdir, addr + len, addr) == 0){
+    p->ptbusy--;
+    return -1;
+  }
+  p->ptbusy--;
+  lcr3(V2P(p->pgdir)); // 해제한 page의 TLB entry 무효화
+  if(v->f && (v->flags & MAP_SHARED))
+    mapcache_trim();
+
+  if(addr == v->addr){
+    v->addr += len;
+    v->off += len;
+  }
+  v->len -= len;
+  if(v->len == 0){
+    if(v->f)
+      fileclose(v->f);
+    memset(v, 0, sizeof(*v));
+  }
+  return 0;
+}
+
+// mmap 영역에서 아직 mapping되지 않은 page에 접근했을 때 호출
+// va가 VMA에 속하고 접근 권한이 있으면 page를 할당하여 0을, 아니면 -1을 반환
+int
+vma_fault(struct proc *p, uint va, int write)
+{
+  struct vma *v;
+
+  if((v = findvma(p, va)) == 0)
+    return -1;
+  if(write && !(v->prot & PROT_WRITE))
+    return -1;
+  p->ptbusy++;
+  if(vmapage(p, v, va) < 0){
+    p->ptbusy--;
+    cprintf("vma_fault: out of memory\n");
+    return -1;
+  }
+  p->ptbusy--;
+  return 0;
+}
+
+// system call 인자로 받은 user 주소 [addr, addr+len)이 prot 권한이 있는 하나의 VMA 안에 있으면 0을, 아니면 -1을 반환
+// kernel이 inode lock 등을 잡은 상태에서 page fault로 file을 읽지 않도록, 아직 mapping되지 않은 page를 미리 mapping
+int
+vma_uaccess(struct proc *p, uint addr, uint len, int prot)
+{
+  struct vma *v;
+  uint va;
+  int r = 0;
+
+  if((v = findvma(p, addr)) == 0 || (v->prot & prot) != prot)
+    return -1;
+  if(addr + len < addr || addr + len > v->addr + v->len)
+    return -1;
+  p->ptbusy++;
+  for(va = PGROUNDDOWN(addr); va < addr + len; va += PGSIZE)
+    if(uva2ka(p->pgdir, (char*)va) == 0 && vmapage(p, v, va) < 0){
+      r = -1;
+      break;
+    }
+  p->ptbusy--;
+  return r;
+}
+
+// va가 속한 VMA의 prot을 반환 (VMA가 없으면 0)
+int
+vma_prot(struct proc *p, uint va)
+{
+  struct vma *v;
+
+  if((v = findvma(p, va)) == 0)
+    return 0;
+  return v->prot;
+}
+
+// va가 속한 VMA의 flags를 반환 (VMA가 없으면 0)
+int
+vma_flags(struct proc *p, uint va)
+{
+  struct vma *v;
+
+  if((v = findvma(p, va)) == 0)
+    return 0;
+  return v->flags;
+}
+
+// addr에서 시작하는 VMA의 크기를 반환 (addr가 VMA의 시작 주소가 아니면 0)
+uint
+vma_len(struct proc *p, uint addr)
+{
+  struct vma *v;
+
+  if((v = findvma(p, addr)) == 0 || v->addr != addr)
+    return 0;
+  return v->len;
+}
+
+// fork 전에 호출
+// MAP_SHARED 영역에서 아직 접근하지 않은 page를 모두 mapping하여, fork 후에 각자 다른 page를 할당하지 않도록 함
+int
+vma_populate(struct proc *p)
+{
+  struct vma *v;
+  uint va;
+  int r = 0;
+
+  p->ptbusy++;
+  for(v = p->vma; v < &p->vma[NVMA] && r == 0; v++){
+    if(v->addr == 0 || !(v->flags & MAP_SHARED))
+      continue;
+    for(va = v->addr; va < v->addr + v->len; va += PGSIZE)
+      if(uva2ka(p->pgdir, (char*)va) == 0 && vmapage(p, v, va) < 0){
+        r = -1;
+        break;
+      }
+  }
+  p->ptbusy--;
+  return r;
+}
+
+// fork에서 parent의 VMA를 child에 복사 (page는 copyuvm에서 공유)
+void
+vma_dup(struct proc *np, struct proc *p)
+{
+  int i;
+
+  for(i = 0; i < NVMA; i++){
+    np->vma[i] = p->vma[i];
+    if(np->vma[i].f)
+      filedup(np->vma[i].f);
+  }
+}
+
+// exit, exec에서 호출
+// 모든 VMA의 변경 내용을 file에 반영하고 VMA를 지움 (page는 freevm에서 해제)
+// MAP_SHARED file mapping의 page는 mapcache에서 버릴 수 있도록 여기서 해제
+void
+vma_clear(struct proc *p)
+{
+  struct vma *v;
+
+  p->ptbusy++;
+  for(v = p->vma; v < &p->vma[NVMA]; v++){
+    if(v->addr == 0)
+      continue;
+    vma_writeback(p, v, v->addr, v->len);
+    if(v->f && (v->flags & MAP_SHARED) && deallocuvm(p->pgdir, v->addr + v->len, v->addr) != 0){
+      lcr3(V2P(p->pgdir));
+      mapcache_trim();
+    }
+    if(v->f)
+      fileclose(v->f);
+    memset(v, 0, sizeof(*v));
+  }
+  p->ptbusy--;
+}
@@ -0,0 +1,202 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "mman.h"
+
+#define PGSIZE  4096
+#define FILESZ  (256*1024)  // 검사에 사용할 file 크기
+#define ROUNDS  4           // file 전체를 읽는 횟수
+
+char buf[PGSIZE];
+
+// read() 반복으로 file 전체의 byte 합을 구함
+uint
+readsum(void)
+{
+  int fd, n, i;
+  uint sum = 0;
+
+  if((fd = open("mmapfile", O_RDONLY)) < 0){
+    printf(1, "open failed\n");
+    exit();
+  }
+  while((n = read(fd, buf, sizeof(buf))) > 0)
+    for(i = 0; i < n; i++)
+      sum += (uchar)buf[i];
+  close(fd);
+  return sum;
+}
+
+// file을 mmap하여 file 전체의 byte 합을 구함
+uint
+mmapsum(void)
+{
+  int fd, i;
+  uchar *p;
+  uint sum = 0;
+
+  if((fd = open("mmapfile", O_RDONLY)) < 0){
+    printf(1, "open failed\n");
+    exit();
+  }
+  if((p = mmap(0, FILESZ, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+    printf(1, "mmap failed\n");
+    exit();
+  }
+  close(fd); // mapping은 file을 닫은 뒤에도 유지됨
+  for(i = 0; i < FILESZ; i++)
+    sum += p[i];
+  munmap(p, FILESZ);
+  return sum;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fd, i, r, start, read_ticks, mmap_ticks;
+  uint rsum, msum;
+  char *p, *q;
+
+  printf(1, "[mmap bench] scan a %d KB file %d times\n", FILESZ / 1024, ROUNDS);
+
+  if((fd = open("mmapfile", O_CREATE | O_RDWR)) < 0){
+    printf(1, "create failed\n");
+    exit();
+  }
+  for(i = 0; i < FILESZ / PGSIZE; i++){
+    for(int j = 0; j < PGSIZE; j++)
+      buf[j] = i + j;
+    if(write(fd, buf, PGSIZE) != PGSIZE){
+      printf(1, "write failed\n");
+      exit();
+    }
+  }
+  close(fd);
+
+  start = uptime();
+  for(r = 0; r < ROUNDS; r++)
+    rsum = readsum();
+  read_ticks = uptime() - start;
+
+  start = uptime();
+  for(r = 0; r < ROUNDS; r++)
+    msum = mmapsum();
+  mmap_ticks = uptime() - start;
+
+  printf(1, "read(): %d ticks, mmap: %d ticks\n", read_ticks, mmap_ticks);
+  if(rsum != msum){
+    printf(1, "[mmap bench] fail (sum %d != %d)\n", rsum, msum);
+    exit();
+  }
+
+  // MAP_SHARED file mapping의 변경 내용은 munmap할 때 file에 반영되어야 함
+  fd = open("mmapfile", O_RDWR);
+  p = mmap(0, FILESZ, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if(p == MAP_FAILED){
+    printf(1, "mmap shared failed\n");
+    exit();
+  }
+  p[0] = 'x';
+  munmap(p, FILESZ);
+  fd = open("mmapfile", O_RDONLY);
+  read(fd, buf, 1);
+  close(fd);
+  if(buf[0] != 'x'){
+    printf(1, "[mmap bench] fail (shared file write lost)\n");
+    exit();
+  }
+
+  // 같은 file을 따로 mapping한 process끼리, 그리고 read/write와 mapping 사이에 변경 내용이 바로 보여야 함
+  fd = open("mmapfile", O_RDWR);
+  p = mmap(0, FILESZ, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(p == MAP_FAILED){
+    printf(1, "mmap shared failed\n");
+    exit();
+  }
+  p[1] = 'y';
+  if(fork() == 0){
+    // fork로 물려받은 mapping을 놓고 새로 mapping
+    munmap(p, FILESZ);
+    q = mmap(0, FILESZ, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(q == MAP_FAILED || q[1] != 'y'){
+      printf(1, "[mmap bench] fail (store not seen by another mapping)\n");
+      exit();
+    }
+    q[2] = 'z';
+    exit();
+  }
+  wait();
+  close(fd);
+  fd = open("mmapfile", O_RDWR);
+  read(fd, buf, 3);
+  if(p[2] != 'z' || buf[1] != 'y' || buf[2] != 'z'){
+    printf(1, "[mmap bench] fail (shared mapping not coherent)\n");
+    exit();
+  }
+  buf[0] = 'w';
+  close(fd);
+  fd = open("mmapfile", O_RDWR);
+  write(fd, buf, 1);
+  close(fd);
+  if(p[0] != 'w'){
+    printf(1, "[mmap bench] fail (write() not seen by mapping)\n");
+    exit();
+  }
+  munmap(p, FILESZ);
+
+  // anonymous MAP_SHARED 영역은 fork 후에도 parent와 child가 공유해야 함
+  p = mmap(0, PGSIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if(p == MAP_FAILED){
+    printf(1, "mmap anonymous failed\n");
+    exit();
+  }
+  if(fork() == 0){
+    p[0] = 42;
+    exit();
+  }
+  wait();
+  if(p[0] != 42){
+    printf(1, "[mmap bench] fail (anonymous shared write lost)\n");
+    exit();
+  }
+
+  // system call에 mmap 영역의 주소를 넘길 수 있어야 함 (아직 접근하지 않은 page 포함)
+  p = mmap(0, 2*PGSIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(p == MAP_FAILED){
+    printf(1, "mmap anonymous failed\n");
+    exit();
+  }
+  fd = open("mmapfile", O_RDONLY);
+  if(read(fd, p + PGSIZE - 1, 2) != 2 || p[PGSIZE - 1] != 'w'){
+    printf(1, "[mmap bench] fail (read() into mapping)\n");
+    exit();
+  }
+  close(fd);
+  strcpy(p + PGSIZE, "mmapfile");
+  if((fd = open(p + PGSIZE, O_RDONLY)) < 0){
+    printf(1, "[mmap bench] fail (path in mapping)\n");
+    exit();
+  }
+  close(fd);
+  munmap(p, 2*PGSIZE);
+
+  // read-only 영역으로는 read()할 수 없고, 접근할 수 없는 영역(prot 0)은 만들 수 없음
+  fd = open("mmapfile", O_RDONLY);
+  p = mmap(0, PGSIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+  if(p == MAP_FAILED || read(fd, p, 1) != -1){
+    printf(1, "[mmap bench] fail (read() into read-only mapping)\n");
+    exit();
+  }
+  munmap(p, PGSIZE);
+  close(fd);
+  if(mmap(0, PGSIZE, 0, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) != MAP_FAILED){
+    printf(1, "[mmap bench] fail (inaccessible mapping created)\n");
+    exit();
+  }
+
+  unlink("mmapfile");
+  printf(1, "[mmap bench] done\n");
+  exit();
+}
@@ -83,6 +83,7 @@ struct segdesc {
 #define NPDENTRIES      1024    // # directory entries per page directory
 #define NPTENTRIES      1024    // # PTEs per page table
 #define PGSIZE          4096    // bytes mapped by a page
+#define HUGEPGSIZE      (PGSIZE*NPTENTRIES) // bytes mapped by a 4MB (PTE_PS) page
 
 #define PTXSHIFT        12      // offset of PTX in a linear address
 #define PDXSHIFT        22      // offset of PDX in a linear address
@@ -94,7 +95,16 @@ struct segdesc {
 #define PTE_P           0x001   // Present
 #define PTE_W           0x002   // Writeable
 #define PTE_U           0x004   // User
+#define PTE_A           0x020   // Accessed
+#define PTE_D           0x040   // Dirty
 #define PTE_PS          0x080   // Page Size
+#define PTE_SHARED      0x200   // mmap MAP_SHARED page (fork 후에도 CoW로 만들지 않고 공유, software 전용 bit)
+#define PTE_SWAP        0x400   // present가 아닌 PTE에서 page가 swap slot(PTE_ADDR >> PTXSHIFT)에 있음을 표시
+
+// Page fault error code flags (tf->err)
+#define FEC_PR          0x001   // Fault caused by a protection violation
+#define FEC_WR          0x002   // Fault caused by a write
+#define FEC_U           0x004   // Fault occurred in user mode
 
 // Address in page table or page directory entry
 #define PTE_ADDR(pte)   ((uint)(pte) & ~0xFFF)
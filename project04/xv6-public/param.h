@@ -9,6 +9,19 @@
 #define MAXARG       32  // max exec arguments
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
-#define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
-#define FSSIZE       1000  // size of file system in blocks
+#define NBUF         (MAXOPBLOCKS*3)  // memory가 부족해도 buffer cache에 남겨두는 최소 buffer 수
+#define BCACHEPCT    25    // buffer cache가 사용할 수 있는 physical memory의 최대 비율(%)
+#define CKPTAGE       1    // commit한 transaction을 logflush가 home location에 쓰기 전에 기다리는 tick 수
+#define COMMITIVL     2    // log transaction을 commit하는 기본 주기(tick), 0이면 매 end_op에서 commit
+#define FSSIZE       8000  // size of file system in blocks
+#ifndef NSWAPBLK
+#define NSWAPBLK    16384  // swap 영역의 block 수 (8MB, fs.img 뒤에 붙음), Makefile의 SWAPBLK로 변경
+#endif
+#define NVMA         16  // mmap으로 만들 수 있는 process당 최대 영역 수
+#define NSHM         16  // 시스템 전체의 최대 shared memory segment 수
+#define SHMMAXPG    256  // shared memory segment 하나의 최대 page 수
+#define NEXECSEG      4  // program 하나의 최대 ELF LOAD segment 수
+#define NEXECPG     256  // 여러 process가 공유하도록 cache에 보관하는 program page 수
+#define NMAPPG      256  // MAP_SHARED file mapping으로 여러 process가 공유할 수 있는 page 수
+#define NHUGEPG      16  // 4MB hugepage로 사용하기 위해 미리 떼어두는 연속된 physical memory 영역 수
 
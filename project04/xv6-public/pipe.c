@@ -9,6 +9,7 @@
 #include "file.h"
 
 #define PIPESIZE 512
+#define PIPEBUF  64   // user memory와 pipe 사이에서 복사할 때 kernel stack에 두는 buffer 크기
 
 struct pipe {
   struct spinlock lock;
@@ -19,6 +20,22 @@ struct pipe {
   int writeopen;  // write fd is still open
 };
 
+// struct pipe는 page보다 훨씬 작으므로 page 하나에 여러 pipe를 담는 slab cache에서 할당
+static struct slabcache *pipecache;
+
+// slab에 처음 만들어질 때 한 번만 lock을 초기화 (pipe는 lock을 release한 상태로 돌려놓음)
+static void
+pipector(void *p)
+{
+  initlock(&((struct pipe*)p)->lock, "pipe");
+}
+
+void
+pipeinit(void)
+{
+  pipecache = slab_create("pipe", sizeof(struct pipe), pipector);
+}
+
 int
 pipealloc(struct file **f0, struct file **f1)
 {
@@ -28,13 +45,12 @@ pipealloc(struct file **f0, struct file **f1)
   *f0 = *f1 = 0;
   if((*f0 = filealloc()) == 0 || (*f1 = filealloc()) == 0)
     goto bad;
-  if((p = (struct pipe*)kalloc()) == 0)
+  if((p = slab_alloc(pipecache)) == 0)
     goto bad;
   p->readopen = 1;
   p->writeopen = 1;
   p->nwrite = 0;
   p->nread = 0;
-  initlock(&p->lock, "pipe");
   (*f0)->type = FD_PIPE;
   (*f0)->readable = 1;
   (*f0)->writable = 0;
@@ -48,7 +64,7 @@ pipealloc(struct file **f0, struct file **f1)
 //PAGEBREAK: 20
  bad:
   if(p)
-    kfree((char*)p);
+    slab_free(pipecache, p);
   if(*f0)
     fileclose(*f0);
   if(*f1)
@@ -69,7 +85,7 @@ pipeclose(struct pipe *p, int writable)
   }
   if(p->readopen == 0 && p->writeopen == 0){
     release(&p->lock);
-    kfree((char*)p);
+    slab_free(pipecache, p);
   } else
     release(&p->lock);
 }
@@ -78,30 +94,42 @@ pipeclose(struct pipe *p, int writable)
 int
 pipewrite(struct pipe *p, char *addr, int n)
 {
-  int i;
+  int i, j, m;
+  char buf[PIPEBUF];
 
-  acquire(&p->lock);
-  for(i = 0; i < n; i++){
-    while(p->nwrite == p->nread + PIPESIZE){  //DOC: pipewrite-full
-      if(p->readopen == 0 || myproc()->killed){
-        release(&p->lock);
-        return -1;
+  for(i = 0; i < n; i += m){
+    // user page가 swap out되어 있으면 page fault handler가 sleep하므로, lock을 잡기 전에 kernel buffer로 복사
+    m = n - i;
+    if(m > sizeof(buf))
+      m = sizeof(buf);
+    memmove(buf, addr + i, m);
+
+    acquire(&p->lock);
+    for(j = 0; j < m; j++){
+      while(p->nwrite == p->nread + PIPESIZE){  //DOC: pipewrite-full
+        if(p->readopen == 0 || myproc()->killed){
+          release(&p->lock);
+          return -1;
+        }
+        wakeup(&p->nread);
+        sleep(&p->nwrite, &p->lock);  //DOC: pipewrite-sleep
       }
-      wakeup(&p->nread);
-      sleep(&p->nwrite, &p->lock);  //DOC: pipewrite-sleep
+      p->data[p->nwrite++ % PIPESIZE] = buf[j];
     }
-    p->data[p->nwrite++ % PIPESIZE] = addr[i];
+    wakeup(&p->nread);  //DOC: pipewrite-wakeup1
+    release(&p->lock);
   }
-  wakeup(&p->nread);  //DOC: pipewrite-wakeup1
-  release(&p->lock);
   return n;
 }
 
 int
 piperead(struct pipe *p, char *addr, int n)
 {
-  int i;
+  int i, j, m;
+  char buf[PIPEBUF];
 
+  // lock을 잡은 동안에는 kernel buffer로만 복사하고, user memory에는 lock을 놓은 뒤 복사
+  // 처음 data가 들어올 때까지만 기다리고, 이후에는 pipe에 남은 data만 PIPEBUF씩 나누어 읽음
   acquire(&p->lock);
   while(p->nread == p->nwrite && p->writeopen){  //DOC: pipe-empty
     if(myproc()->killed){
@@ -110,12 +138,18 @@ piperead(struct pipe *p, char *addr, int n)
     }
     sleep(&p->nread, &p->lock); //DOC: piperead-sleep
   }
-  for(i = 0; i < n; i++){  //DOC: piperead-copy
-    if(p->nread == p->nwrite)
-      break;
-    addr[i] = p->data[p->nread++ % PIPESIZE];
+  for(i = 0; i < n && p->nread != p->nwrite; i += m){
+    m = 0;
+    for(j = 0; j < sizeof(buf) && i + j < n; j++){  //DOC: piperead-copy
+      if(p->nread == p->nwrite)
+        break;
+      buf[m++] = p->data[p->nread++ % PIPESIZE];
+    }
+    wakeup(&p->nwrite);  //DOC: piperead-wakeup
+    release(&p->lock);
+    memmove(addr + i, buf, m);
+    acquire(&p->lock);
   }
-  wakeup(&p->nwrite);  //DOC: piperead-wakeup
   release(&p->lock);
   return i;
 }
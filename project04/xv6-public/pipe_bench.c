@@ -0,0 +1,72 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "memstat.h"
+
+#define NPIPE   6      // 한 process가 동시에 열어둘 pipe 수 (fd 16개 중 0, 1, 2 제외)
+#define N       10000  // 만들고 닫는 pipe 수
+#define NCHILD  4      // 동시에 pipe를 만들고 닫는 process 수
+
+// n개의 pipe를 만들고 바로 닫음
+void
+churn(int n)
+{
+  int fd[2];
+
+  for(int i = 0; i < n; i++){
+    if(pipe(fd) < 0){
+      printf(1, "pipe failed\n");
+      exit();
+    }
+    close(fd[0]);
+    close(fd[1]);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct memstat before, after;
+  int fds[NPIPE][2], start;
+
+  printf(1, "[pipe bench] start\n");
+
+  // 열려 있는 pipe들이 사용하는 page 수 (이전에는 pipe마다 page 하나)
+  memstat(&before);
+  for(int i = 0; i < NPIPE; i++){
+    if(pipe(fds[i]) < 0){
+      printf(1, "pipe failed\n");
+      exit();
+    }
+  }
+  memstat(&after);
+  printf(1, "%d pipes: %d pages in use (slab pages %d -> %d)\n", NPIPE,
+         before.free - after.free, before.slab, after.slab);
+  for(int i = 0; i < NPIPE; i++){
+    close(fds[i][0]);
+    close(fds[i][1]);
+  }
+
+  start = uptime();
+  churn(N);
+  printf(1, "1 process: %d pipe create/close %d ticks\n", N, uptime() - start);
+
+  start = uptime();
+  for(int i = 0; i < NCHILD; i++){
+    int pid = fork();
+    if(pid < 0){
+      printf(1, "fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      churn(N / NCHILD);
+      exit();
+    }
+  }
+  for(int i = 0; i < NCHILD; i++)
+    wait();
+  printf(1, "%d processes: %d pipe create/close %d ticks\n", NCHILD, N, uptime() - start);
+
+  printf(1, "[pipe bench] done\n");
+  exit();
+}
@@ -6,6 +6,7 @@
 #include "x86.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "memstat.h"
 
 struct {
   struct spinlock lock;
@@ -88,11 +89,21 @@ allocproc(void)
 found:
   p->state = EMBRYO;
   p->pid = nextpid++;
+  p->cownext = 0;
+  p->cowwin = 0;
+  p->hugepage = 0;
+  p->ksm = 0;
+  memset(p->vma, 0, sizeof(p->vma));
+  p->exe = 0;
+  memset(p->execseg, 0, sizeof(p->execseg));
+  p->rss = p->cowpg = p->shmpg = p->ptpg = p->maxrss = 0;
+  p->memlimit = 0;
+  p->ptbusy = 0;
 
   release(&ptable.lock);
 
   // Allocate kernel stack.
-  if((p->kstack = kalloc()) == 0){
+  if((p->kstack = kalloc_type(PG_KSTACK)) == 0){
     p->state = UNUSED;
     return 0;
   }
@@ -115,6 +126,101 @@ found:
   return p;
 }
 
+// user memory 없이 kernel 안에서만 실행되는 process를 만듦 (swap daemon 등)
+// fn은 return하지 않아야 함
+void
+kthread(char *name, void (*fn)(void))
+{
+  struct proc *p;
+
+  if((p = allocproc()) == 0 || (p->pgdir = setupkvm()) == 0)
+    panic("kthread");
+  p->sz = 0;
+  p->parent = initproc;
+  safestrcpy(p->name, name, sizeof(p->name));
+
+  // forkret이 return하면 trapret 대신 fn으로 가도록 allocproc이 넣어둔 return 주소를 바꿈
+  *(uint*)((char*)p->context + sizeof(*p->context)) = (uint)fn;
+
+  acquire(&ptable.lock);
+  p->state = RUNNABLE;
+  release(&ptable.lock);
+}
+
+// clock(second chance) 알고리즘으로 swap out할 user page를 하나 골라, PTE가 swap slot을 가리키도록 바꾸고 page를 반환
+// 다른 CPU에서 실행 중인 process는 TLB를 무효화할 수 없으므로 건너뛰며, 고를 page가 없으면 0을 반환
+// deallocuvm, mmap, munmap 중인 process(ptbusy)는 PTE를 읽은 뒤 page를 쓰거나 해제하는 중일 수 있으므로 건너뜀
+char*
+clock_evict(uint slot)
+{
+  static int hand;      // clock hand가 가리키는 process
+  static uint handva;   // clock hand가 가리키는 가상 주소
+  struct proc *p, *curproc = myproc();
+  char *mem = 0;
+  int r, wrapped = 0;
+
+  acquire(&ptable.lock);
+  while(mem == 0){
+    p = &ptable.proc[hand];
+    if(handva >= p->sz || p->pgdir == 0 || p->ptbusy ||
+       (p->state != RUNNABLE && p->state != SLEEPING && p != curproc)){
+      handva = 0;
+      hand = (hand + 1) % NPROC;
+      if(hand == 0 && ++wrapped > 2) // 두 바퀴를 돌아도 없으면 포기 (첫 바퀴에서는 PTE_A만 지워질 수 있음)
+        break;
+      continue;
+    }
+    r = swap_check(p->pgdir, handva);
+    if(r < 0){ // page table이 없거나 swap out할 수 없는 4MB 영역
+      handva = PGADDR(PDX(handva) + 1, 0, 0);
+      if(handva == 0)
+        handva = p->sz;
+      continue;
+    }
+    if(r == 2){
+      mem = swap_unmap(p->pgdir, handva, slot);
+      p->rss--; // p는 실행 중이 아니거나 현재 process이므로 ptable.lock을 잡은 상태에서 바로 갱신
+      if(p == curproc)
+        invlpg((void*)handva);
+    }
+    handva += PGSIZE;
+  }
+  release(&ptable.lock);
+  return mem;
+}
+
+// ksm을 켠 process의 user page를 순서대로 최대 n개 확인하여 ksm_page()로 넘김
+// ksm_page가 page table을 바꿀 수 있도록, 다른 CPU에서 실행 중이 아닌 process만 ptable.lock을 잡은 상태로 넘김
+// 실행 중이 아니어도 deallocuvm, mmap, munmap 도중에 멈춘 process(ptbusy)는 PTE를 읽은 뒤 page를 해제하거나
+// kernel 주소로 쓰는 중일 수 있으므로, clock_evict와 마찬가지로 건너뜀
+// lock을 오래 잡지 않도록 page마다 lock을 놓음
+void
+ksm_scan(int n)
+{
+  static int hand;      // 확인 중인 process
+  static uint handva;   // 다음에 확인할 가상 주소
+  struct proc *p;
+  int skipped = 0;
+
+  while(n > 0 && skipped < NPROC){
+    acquire(&ptable.lock);
+    p = &ptable.proc[hand];
+    if(!p->ksm || p->pgdir == 0 || handva >= p->sz || p->ptbusy ||
+       (p->state != RUNNABLE && p->state != SLEEPING)){
+      release(&ptable.lock);
+      handva = 0;
+      hand = (hand + 1) % NPROC;
+      skipped++; // 확인할 process가 하나도 없으면 한 바퀴 돌고 멈춤
+      continue;
+    }
+    skipped = 0;
+    ksm_page(p, handva);
+    release(&ptable.lock);
+    handva += PGSIZE;
+    n--;
+  }
+}
+
 //PAGEBREAK: 32
 // Set up first user process.
 void
@@ -129,6 +235,7 @@ userinit(void)
   if((p->pgdir = setupkvm()) == 0)
     panic("userinit: out of memory?");
   inituvm(p->pgdir, _binary_initcode_start, (int)_binary_initcode_size);
+  vmacct(p);
   p->sz = PGSIZE;
   memset(p->tf, 0, sizeof(*p->tf));
   p->tf->cs = (SEG_UCODE << 3) | DPL_USER;
@@ -163,11 +270,17 @@ growproc(int n)
 
   sz = curproc->sz;
   if(n > 0){
-    if((sz = allocuvm(curproc->pgdir, sz, sz + n)) == 0)
+    // 주소 공간만 늘리고 physical page는 처음 접근할 때 page fault handler에서 할당 (lazy allocation)
+    if(sz + n < sz || sz + n > MMAPBASE)
       return -1;
+    sz += n;
   } else if(n < 0){
     if((sz = deallocuvm(curproc->pgdir, sz, sz + n)) == 0)
       return -1;
+    // 줄어든 영역을 다시 늘렸을 때 program file이 아닌 0으로 채워진 page가 mapping되도록 segment도 줄임
+    for(struct execseg *s = curproc->execseg; s < &curproc->execseg[NEXECSEG]; s++)
+      if(s->filesz && s->vaddr + s->filesz > sz)
+        s->filesz = sz > s->vaddr ? sz - s->vaddr : 0;
   }
   curproc->sz = sz;
   switchuvm(curproc);
@@ -190,13 +303,28 @@ fork(void)
   }
 
   // Copy process state from proc.
-  if((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0){
+  // MAP_SHARED 영역은 child와 같은 page를 공유하도록 copyuvm 전에 모든 page를 mapping
+  if(vma_populate(curproc) < 0 ||
+     (np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0){
     kfree(np->kstack);
     np->kstack = 0;
     np->state = UNUSED;
     return -1;
   }
   np->sz = curproc->sz;
+  np->hugepage = curproc->hugepage;
+  np->ksm = curproc->ksm;
+  // child는 parent와 같은 page table을 공유하므로 copyuvm이 갱신한 parent의 counter를 그대로 사용
+  np->rss = curproc->rss;
+  np->cowpg = curproc->cowpg;
+  np->shmpg = curproc->shmpg;
+  np->ptpg = curproc->ptpg;
+  np->maxrss = np->rss;
+  np->memlimit = curproc->memlimit;
+  vma_dup(np, curproc);
+  if(curproc->exe) // 아직 읽어오지 않은 program page는 child도 같은 file에서 읽어옴
+    np->exe = exedup(curproc->exe);
+  memmove(np->execseg, curproc->execseg, sizeof(np->execseg));
   np->parent = curproc;
   *np->tf = *curproc->tf;
 
@@ -221,6 +349,56 @@ fork(void)
   return pid;
 }
 
+// fork() 직후 exec()하는 것과 같은 child를 만들지만, parent의 address space를 복사하지 않고
+// path의 ELF로부터 child의 address space를 바로 만듦
+// child의 fd 0~2는 fds[0~2]로 설정하며(0이면 닫힌 상태), 그 외의 fd는 물려주지 않음
+int
+spawn(char *path, char **argv, struct file **fds)
+{
+  int i, pid;
+  uint entry, sp;
+  char *s, *last;
+  struct proc *np;
+  struct proc *curproc = myproc();
+
+  // Allocate process.
+  if((np = allocproc()) == 0){
+    return -1;
+  }
+
+  if(loadimage(path, argv, &np->pgdir, &np->sz, &entry, &sp, &np->exe, np->execseg) < 0){
+    kfree(np->kstack);
+    np->kstack = 0;
+    np->state = UNUSED;
+    return -1;
+  }
+  vmacct(np);
+  np->parent = curproc;
+  *np->tf = *curproc->tf;
+  np->tf->eip = entry;  // main
+  np->tf->esp = sp;
+
+  for(i = 0; i < 3; i++)
+    if(fds[i])
+      np->ofile[i] = filedup(fds[i]);
+  np->cwd = idup(curproc->cwd);
+
+  for(last=s=path; *s; s++)
+    if(*s == '/')
+      last = s+1;
+  safestrcpy(np->name, last, sizeof(np->name));
+
+  pid = np->pid;
+
+  acquire(&ptable.lock);
+
+  np->state = RUNNABLE;
+
+  release(&ptable.lock);
+
+  return pid;
+}
+
 // Exit the current process.  Does not return.
 // An exited process remains in the zombie state
 // until its parent calls wait() to find out it exited.
@@ -234,6 +412,9 @@ exit(void)
   if(curproc == initproc)
     panic("init exiting");
 
+  // mmap 영역의 변경 내용을 file에 반영하고 file을 닫음 (page는 wait()의 freevm에서 해제)
+  vma_clear(curproc);
+
   // Close all open files.
   for(fd = 0; fd < NOFILE; fd++){
     if(curproc->ofile[fd]){
@@ -244,8 +425,11 @@ exit(void)
 
   begin_op();
   iput(curproc->cwd);
+  if(curproc->exe)
+    exeput(curproc->exe);
   end_op();
   curproc->cwd = 0;
+  curproc->exe = 0;
 
   acquire(&ptable.lock);
 
@@ -324,6 +508,7 @@ scheduler(void)
 {
   struct proc *p;
   struct cpu *c = mycpu();
+  int idle;
   c->proc = 0;
   
   for(;;){
@@ -331,10 +516,12 @@ scheduler(void)
     sti();
 
     // Loop over process table looking for process to run.
+    idle = 1;
     acquire(&ptable.lock);
     for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
       if(p->state != RUNNABLE)
         continue;
+      idle = 0;
 
       // Switch to chosen process.  It is the process's job
       // to release ptable.lock and then reacquire it
@@ -352,6 +539,9 @@ scheduler(void)
     }
     release(&ptable.lock);
 
+    // 실행할 process가 없으면 이후 할당을 위해 page를 미리 0으로 채워둠
+    if(idle)
+      kzero_idle();
   }
 }
 
@@ -496,6 +686,56 @@ kill(int pid)
   return -1;
 }
 
+// pid인 process의 memory 사용량을 pm에 복사, 해당 process가 없으면 -1을 반환
+// counter는 page table을 바꿀 때마다 갱신되므로 page table을 순회하지 않음
+int
+getprocmem(int pid, struct procmem *pm)
+{
+  struct proc *p;
+  struct procmem m;
+
+  acquire(&ptable.lock);
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    if(p->pid == pid && p->state != UNUSED && p->state != ZOMBIE){
+      m.rss = p->rss;
+      m.cow = p->cowpg;
+      m.shared = p->shmpg;
+      m.pgtab = p->ptpg;
+      m.maxrss = p->maxrss;
+      m.limit = p->memlimit;
+      release(&ptable.lock);
+      // pm은 user memory이므로 page fault(lazy allocation, swap in 등)가 날 수 있어 ptable.lock을 놓은 뒤에 복사
+      *pm = m;
+      return 0;
+    }
+  }
+  release(&ptable.lock);
+  return -1;
+}
+
+// pid인 process가 혼자 사용할 수 있는 page 수를 limit으로 제한하고(0이면 제한 없음) 이전 값을 반환
+// 이미 limit보다 많이 사용 중이면 page를 빼앗지 않고, 이후 새로운 page 할당만 실패함
+int
+setmemlimit(int pid, int limit)
+{
+  struct proc *p;
+  int old;
+
+  if(limit < 0)
+    return -1;
+  acquire(&ptable.lock);
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    if(p->pid == pid && p->state != UNUSED && p->state != ZOMBIE){
+      old = p->memlimit;
+      p->memlimit = limit;
+      release(&ptable.lock);
+      return old;
+    }
+  }
+  release(&ptable.lock);
+  return -1;
+}
+
 //PAGEBREAK: 36
 // Print a process listing to console.  For debugging.
 // Runs when user types ^P on console.
@@ -32,6 +32,23 @@ struct context {
   uint eip;
 };
 
+// mmap으로 만든 가상 메모리 영역
+struct vma {
+  uint addr;                   // 시작 주소 (0이면 사용하지 않는 항목)
+  uint len;                    // 크기 (PGSIZE의 배수)
+  int prot;                    // PROT_READ, PROT_WRITE
+  int flags;                   // MAP_SHARED 또는 MAP_PRIVATE, MAP_ANONYMOUS
+  struct file *f;              // file-backed mapping이면 mapping한 file
+  uint off;                    // file 안에서 addr에 대응하는 offset
+};
+
+// exec에서 바로 읽지 않고 처음 접근할 때 page fault에서 file을 읽어오는 ELF segment
+struct execseg {
+  uint vaddr;                  // 시작 주소 (page 단위로 정렬)
+  uint filesz;                 // file 내용이 있는 크기 (0이면 사용하지 않는 항목)
+  uint off;                    // file 안에서 vaddr에 대응하는 offset
+};
+
 enum procstate { UNUSED, EMBRYO, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
 
 // Per-process state
@@ -49,6 +66,21 @@ struct proc {
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
   char name[16];               // Process name (debugging)
+  uint cownext;                // 순차적인 write라면 다음 CoW fault가 발생할 것으로 예상되는 주소
+  int cowwin;                  // CoW fault 한 번에 처리할 page 수 (fault-around 범위)
+  int hugepage;                // 0이 아니면 heap의 4MB 영역을 hugepage로 mapping
+  int ksm;                     // 0이 아니면 ksmd가 같은 내용의 page를 찾아 합침
+  struct vma vma[NVMA];        // mmap으로 만든 영역
+  struct inode *exe;           // 실행 중인 program file (execseg의 page를 읽어옴)
+  struct execseg execseg[NEXECSEG]; // 아직 읽어오지 않은 page가 있을 수 있는 ELF segment
+  // page table을 바꿀 때마다 갱신하는 memory counter (procmem system call로 확인)
+  uint rss;                    // mapping된 physical page 수 (hugepage는 NPTENTRIES개)
+  uint cowpg;                  // rss 중 CoW로 공유하는(read-only) page 수
+  uint shmpg;                  // rss 중 MAP_SHARED page 수
+  uint ptpg;                   // page directory, page table page 수
+  uint maxrss;                 // rss의 최댓값
+  uint memlimit;               // 혼자 사용하는 page 수(rss - cowpg - shmpg)의 상한, 0이면 제한 없음
+  int ptbusy;                  // 0이 아니면 자신의 PTE를 바꾸는 중이므로 swapd, ksmd가 page table을 건드리지 않음
 };
 
 // Process memory is laid out contiguously, low addresses first:
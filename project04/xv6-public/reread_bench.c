@@ -0,0 +1,69 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "memstat.h"
+
+#define NFILE   16          // file 하나의 최대 크기(MAXFILE)가 70KB이므로 1MB를 64KB file 16개로 나눔
+#define FILESZ  (64*1024)
+#define ROUNDS  4
+
+// 1MB를 write한 뒤 여러 번 다시 읽어 buffer cache의 hit rate와 시간을 측정
+// buffer cache가 30개 buffer로 고정되어 있을 때는 매번 disk에서 다시 읽음
+char buf[4096];
+
+void
+name(char *path, int i)
+{
+  strcpy(path, "rr00");
+  path[2] = '0' + i / 10;
+  path[3] = '0' + i % 10;
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct memstat before, after;
+  char path[8];
+  int fd, start;
+
+  printf(1, "[reread bench] %d KB, %d rounds\n", NFILE * FILESZ / 1024, ROUNDS);
+
+  memset(buf, 'r', sizeof(buf));
+  for(int i = 0; i < NFILE; i++){
+    name(path, i);
+    if((fd = open(path, O_CREATE | O_RDWR)) < 0){
+      printf(1, "create %s failed\n", path);
+      exit();
+    }
+    for(int n = 0; n < FILESZ; n += sizeof(buf)){
+      if(write(fd, buf, sizeof(buf)) != sizeof(buf)){
+        printf(1, "write %s failed\n", path);
+        exit();
+      }
+    }
+    close(fd);
+  }
+
+  for(int r = 0; r < ROUNDS; r++){
+    memstat(&before);
+    start = uptime();
+    for(int i = 0; i < NFILE; i++){
+      name(path, i);
+      fd = open(path, O_RDONLY);
+      while(read(fd, buf, sizeof(buf)) > 0)
+        ;
+      close(fd);
+    }
+    memstat(&after);
+    printf(1, "round %d: %d ticks, hit %d miss %d, buffers %d\n", r, uptime() - start,
+           after.bcachehit - before.bcachehit, after.bcachemiss - before.bcachemiss, after.bcachebuf);
+  }
+
+  for(int i = 0; i < NFILE; i++){
+    name(path, i);
+    unlink(path);
+  }
+  printf(1, "OK\n");
+  exit();
+}
@@ -0,0 +1,42 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define PGSIZE  4096
+#define SIZE    (64*1024*1024)  // sbrk로 늘리는 크기
+#define STRIDE  16              // STRIDE page마다 1 page씩만 접근
+
+int
+main(int argc, char *argv[])
+{
+  int start, elapsed, pp_before, pp_after, pp_touched;
+  char *p;
+
+  printf(1, "[sbrk bench] sbrk(%d MB)\n", SIZE / (1024*1024));
+
+  pp_before = countpp();
+  start = uptime();
+  if((p = sbrk(SIZE)) == (char*)-1){
+    printf(1, "sbrk failed\n");
+    exit();
+  }
+  elapsed = uptime() - start;
+  pp_after = countpp();
+  printf(1, "sbrk: %d ticks, resident pages %d -> %d\n", elapsed, pp_before, pp_after);
+
+  // 일부 page에만 접근하면 접근한 page만 할당되어야 함
+  start = uptime();
+  for(int i = 0; i < SIZE / PGSIZE; i += STRIDE)
+    p[i * PGSIZE] = 1;
+  elapsed = uptime() - start;
+  pp_touched = countpp();
+  printf(1, "touch every %d pages: %d ticks, resident pages %d (+%d)\n",
+         STRIDE, elapsed, pp_touched, pp_touched - pp_after);
+
+  if(pp_touched - pp_after != SIZE / PGSIZE / STRIDE)
+    printf(1, "[sbrk bench] fail\n");
+  else
+    printf(1, "[sbrk bench] done\n");
+
+  exit();
+}
@@ -52,12 +52,45 @@ struct backcmd {
 int fork1(void);  // Fork but panics on failure.
 void panic(char*);
 struct cmd *parsecmd(char*);
+void freecmd(struct cmd*);
+
+// redirection만 붙은 단순 명령이면 fork 없이 spawn으로 실행하고 child의 pid를 반환
+// fds는 child의 fd 0~2로 사용할 fd이며, redirection을 만나면 해당 항목을 바꿈
+// 그 외의 명령이거나 실행에 실패하면 -1을 반환하므로 호출한 쪽에서 fork 후 runcmd로 실행해야 함
+int
+spawncmd(struct cmd *cmd, int *fds)
+{
+  int fd, pid;
+  struct execcmd *ecmd;
+  struct redircmd *rcmd;
+
+  if(cmd == 0)
+    return -1;
+
+  switch(cmd->type){
+  case EXEC:
+    ecmd = (struct execcmd*)cmd;
+    if(ecmd->argv[0] == 0)
+      return -1;
+    return spawn(ecmd->argv[0], ecmd->argv, fds);
+
+  case REDIR:
+    rcmd = (struct redircmd*)cmd;
+    if((fd = open(rcmd->file, rcmd->mode)) < 0)
+      return -1;
+    fds[rcmd->fd] = fd;
+    pid = spawncmd(rcmd->cmd, fds);
+    close(fd);
+    return pid;
+  }
+  return -1;
+}
 
 // Execute cmd.  Never returns.
 void
 runcmd(struct cmd *cmd)
 {
-  int p[2];
+  int p[2], fds[3];
   struct backcmd *bcmd;
   struct execcmd *ecmd;
   struct listcmd *lcmd;
@@ -101,14 +134,20 @@ runcmd(struct cmd *cmd)
     pcmd = (struct pipecmd*)cmd;
     if(pipe(p) < 0)
       panic("pipe");
-    if(fork1() == 0){
+    fds[0] = 0;
+    fds[1] = p[1];
+    fds[2] = 2;
+    if(spawncmd(pcmd->left, fds) < 0 && fork1() == 0){
       close(1);
       dup(p[1]);
       close(p[0]);
       close(p[1]);
       runcmd(pcmd->left);
     }
-    if(fork1() == 0){
+    fds[0] = p[0];
+    fds[1] = 1;
+    fds[2] = 2;
+    if(spawncmd(pcmd->right, fds) < 0 && fork1() == 0){
       close(0);
       dup(p[0]);
       close(p[0]);
@@ -145,7 +184,8 @@ int
 main(void)
 {
   static char buf[100];
-  int fd;
+  int fd, fds[3];
+  struct cmd *cmd;
 
   // Ensure that three file descriptors are open.
   while((fd = open("console", O_RDWR)) >= 0){
@@ -164,9 +204,16 @@ main(void)
         printf(2, "cannot cd %s\n", buf+3);
       continue;
     }
-    if(fork1() == 0)
-      runcmd(parsecmd(buf));
+    // 단순 명령은 shell의 address space를 복사하지 않도록 spawn으로 실행
+    if((cmd = parsecmd(buf)) == 0)
+      continue;
+    fds[0] = 0;
+    fds[1] = 1;
+    fds[2] = 2;
+    if(spawncmd(cmd, fds) < 0 && fork1() == 0)
+      runcmd(cmd);
     wait();
+    freecmd(cmd);
   }
   exit();
 }
@@ -324,18 +371,35 @@ struct cmd *parsepipe(char**, char*);
 struct cmd *parseexec(char**, char*);
 struct cmd *nulterminate(struct cmd*);
 
+// shell 자신(parent)이 parsecmd를 호출하므로 문법 오류가 있어도 shell이 종료되지 않도록
+// panic 대신 오류를 출력하고 표시만 해두며, parsecmd가 0을 반환
+int syntaxerr;
+
+void
+syntax(char *s)
+{
+  if(!syntaxerr)
+    printf(2, "%s\n", s);
+  syntaxerr = 1;
+}
+
 struct cmd*
 parsecmd(char *s)
 {
   char *es;
   struct cmd *cmd;
 
+  syntaxerr = 0;
   es = s + strlen(s);
   cmd = parseline(&s, es);
   peek(&s, es, "");
-  if(s != es){
+  if(s != es && !syntaxerr){
     printf(2, "leftovers: %s\n", s);
-    panic("syntax");
+    syntax("syntax");
+  }
+  if(syntaxerr){
+    freecmd(cmd);
+    return 0;
   }
   nulterminate(cmd);
   return cmd;
@@ -379,8 +443,10 @@ parseredirs(struct cmd *cmd, char **ps, char *es)
 
   while(peek(ps, es, "<>")){
     tok = gettoken(ps, es, 0, 0);
-    if(gettoken(ps, es, &q, &eq) != 'a')
-      panic("missing file for redirection");
+    if(gettoken(ps, es, &q, &eq) != 'a'){
+      syntax("missing file for redirection");
+      break;
+    }
     switch(tok){
     case '<':
       cmd = redircmd(cmd, q, eq, O_RDONLY, 0);
@@ -405,8 +471,10 @@ parseblock(char **ps, char *es)
     panic("parseblock");
   gettoken(ps, es, 0, 0);
   cmd = parseline(ps, es);
-  if(!peek(ps, es, ")"))
-    panic("syntax - missing )");
+  if(!peek(ps, es, ")")){
+    syntax("syntax - missing )");
+    return cmd;
+  }
   gettoken(ps, es, 0, 0);
   cmd = parseredirs(cmd, ps, es);
   return cmd;
@@ -431,13 +499,17 @@ parseexec(char **ps, char *es)
   while(!peek(ps, es, "|)&;")){
     if((tok=gettoken(ps, es, &q, &eq)) == 0)
       break;
-    if(tok != 'a')
-      panic("syntax");
+    if(tok != 'a'){
+      syntax("syntax");
+      break;
+    }
+    if(argc >= MAXARGS-1){
+      syntax("too many args");
+      break;
+    }
     cmd->argv[argc] = q;
     cmd->eargv[argc] = eq;
     argc++;
-    if(argc >= MAXARGS)
-      panic("too many args");
     ret = parseredirs(ret, ps, es);
   }
   cmd->argv[argc] = 0;
@@ -491,3 +563,41 @@ nulterminate(struct cmd *cmd)
   }
   return cmd;
 }
+
+// parsecmd로 만든 command tree의 node를 모두 해제 (문자열은 buf를 가리키므로 해제하지 않음)
+void
+freecmd(struct cmd *cmd)
+{
+  struct backcmd *bcmd;
+  struct listcmd *lcmd;
+  struct pipecmd *pcmd;
+  struct redircmd *rcmd;
+
+  if(cmd == 0)
+    return;
+
+  switch(cmd->type){
+  case REDIR:
+    rcmd = (struct redircmd*)cmd;
+    freecmd(rcmd->cmd);
+    break;
+
+  case PIPE:
+    pcmd = (struct pipecmd*)cmd;
+    freecmd(pcmd->left);
+    freecmd(pcmd->right);
+    break;
+
+  case LIST:
+    lcmd = (struct listcmd*)cmd;
+    freecmd(lcmd->left);
+    freecmd(lcmd->right);
+    break;
+
+  case BACK:
+    bcmd = (struct backcmd*)cmd;
+    freecmd(bcmd->cmd);
+    break;
+  }
+  free(cmd);
+}
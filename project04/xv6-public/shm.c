@@ -0,0 +1,132 @@
+// System V 방식의 shared memory segment
+// segment의 page는 refc_arr의 참조 횟수로 관리하며, segment 자신이 1개, segment를 attach한 각 mapping이 1개씩 참조
+// attach한 영역은 MAP_SHARED | MAP_ANONYMOUS VMA로 만들어지므로 fork, exit, exec은 mmap 영역과 동일하게 처리됨
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "mman.h"
+#include "memstat.h"
+
+struct shmseg {
+  int key;                     // shmget에 전달된 key
+  int npages;                  // segment의 page 수 (0이면 사용하지 않는 항목)
+  char *pages[SHMMAXPG];       // segment의 physical page
+};
+
+struct {
+  struct spinlock lock;
+  struct shmseg seg[NSHM];
+} shmtable;
+
+void
+shminit(void)
+{
+  initlock(&shmtable.lock, "shm");
+}
+
+// key에 해당하는 segment의 id를 반환하고, 없으면 size 크기의 segment를 새로 만듦
+// 실패하면 -1을 반환
+int
+shmget(int key, uint size)
+{
+  struct shmseg *s, *empty = 0;
+  int i, npages = PGROUNDUP(size) / PGSIZE;
+
+  acquire(&shmtable.lock);
+  for(s = shmtable.seg; s < &shmtable.seg[NSHM]; s++){
+    if(s->npages && s->key == key){
+      release(&shmtable.lock);
+      return s - shmtable.seg;
+    }
+    if(s->npages == 0 && empty == 0)
+      empty = s;
+  }
+  if(empty == 0 || npages == 0 || npages > SHMMAXPG){
+    release(&shmtable.lock);
+    return -1;
+  }
+
+  for(i = 0; i < npages; i++){
+    if((empty->pages[i] = kalloc_zeroed(PG_USER)) == 0){
+      while(--i >= 0)
+        kfree(empty->pages[i]);
+      release(&shmtable.lock);
+      return -1;
+    }
+  }
+  empty->key = key;
+  empty->npages = npages;
+  release(&shmtable.lock);
+  return empty - shmtable.seg;
+}
+
+// segment id를 현재 process의 빈 mmap 영역에 attach하고 시작 주소를 반환, 실패하면 0을 반환
+uint
+shmat(int id)
+{
+  struct proc *p = myproc();
+  struct shmseg *s;
+  uint addr;
+  int i;
+
+  if(id < 0 || id >= NSHM)
+    return 0;
+  s = &shmtable.seg[id];
+
+  acquire(&shmtable.lock); // attach하는 동안 shmrm으로 page가 free되지 않도록 함
+  if(s->npages == 0 ||
+     (addr = mmap(s->npages * PGSIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, 0, 0)) == 0){
+    release(&shmtable.lock);
+    return 0;
+  }
+  for(i = 0; i < s->npages; i++){
+    if(mapuserpage(p->pgdir, addr + i*PGSIZE, s->pages[i], PTE_W | PTE_U | PTE_SHARED) < 0){
+      release(&shmtable.lock);
+      munmap(addr, s->npages * PGSIZE); // 이미 mapping한 page의 참조만 놓음
+      return 0;
+    }
+    incr_refc(V2P(s->pages[i]));
+  }
+  release(&shmtable.lock);
+  return addr;
+}
+
+// shmat으로 attach한 영역을 detach
+int
+shmdt(uint addr)
+{
+  uint len;
+
+  if((len = vma_len(myproc(), addr)) == 0)
+    return -1;
+  return munmap(addr, len);
+}
+
+// segment를 삭제
+// 아직 attach한 process가 있으면 page는 마지막 process가 detach할 때 free됨
+int
+shmrm(int id)
+{
+  struct shmseg *s;
+  int i;
+
+  if(id < 0 || id >= NSHM)
+    return -1;
+  s = &shmtable.seg[id];
+
+  acquire(&shmtable.lock);
+  if(s->npages == 0){
+    release(&shmtable.lock);
+    return -1;
+  }
+  for(i = 0; i < s->npages; i++)
+    kfree(s->pages[i]); // segment의 참조를 놓음
+  s->npages = 0;
+  release(&shmtable.lock);
+  return 0;
+}
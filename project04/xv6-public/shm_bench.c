@@ -0,0 +1,133 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define PGSIZE  4096
+#define TOTAL   (4*1024*1024)  // producer가 consumer에게 보내는 크기
+#define CHUNK   PGSIZE
+#define NSLOT   15             // shared memory ring의 slot 수
+#define SHMKEY  3021
+
+// shared memory segment의 첫 page는 ring의 head/tail, 나머지 page는 각 slot
+struct ring {
+  volatile uint head;  // producer가 채운 slot 수
+  volatile uint tail;  // consumer가 비운 slot 수
+};
+
+char buf[CHUNK];
+
+uint
+checksum(char *p, int n)
+{
+  uint sum = 0;
+
+  for(int i = 0; i < n; i++)
+    sum += (uchar)p[i];
+  return sum;
+}
+
+// producer가 보낸 내용을 TOTAL byte 모두 받았는지 확인하기 위해 producer와 같은 방법으로 합을 계산
+uint
+expected(void)
+{
+  uint sum = 0;
+
+  for(int n = 0; n < TOTAL / CHUNK; n++){
+    memset(buf, n, CHUNK);
+    sum += checksum(buf, CHUNK);
+  }
+  return sum;
+}
+
+int
+pipetest(void)
+{
+  int fd[2], n, got = 0;
+  uint sum = 0;
+
+  if(pipe(fd) < 0){
+    printf(1, "pipe failed\n");
+    exit();
+  }
+  if(fork() == 0){
+    close(fd[0]);
+    for(n = 0; n < TOTAL / CHUNK; n++){
+      memset(buf, n, CHUNK);
+      write(fd[1], buf, CHUNK);
+    }
+    exit();
+  }
+  close(fd[1]);
+  while((n = read(fd[0], buf, CHUNK)) > 0){
+    sum += checksum(buf, n);
+    got += n;
+  }
+  close(fd[0]);
+  wait();
+  return got == TOTAL && sum == expected();
+}
+
+// producer와 consumer가 서로 다른 CPU에서 실행되는 경우를 가정하여 busy-wait으로 동기화
+int
+shmtest(void)
+{
+  int id, n, got = 0;
+  uint sum = 0;
+  char *base;
+  struct ring *r;
+
+  if((id = shmget(SHMKEY, (NSLOT + 1) * PGSIZE)) < 0 || (base = shmat(id)) == (char*)-1){
+    printf(1, "shm failed\n");
+    exit();
+  }
+  r = (struct ring*)base;
+  r->head = r->tail = 0;
+
+  if(fork() == 0){
+    // child는 fork로 물려받은 mapping 대신 직접 attach해서 사용
+    shmdt(base);
+    base = shmat(id);
+    r = (struct ring*)base;
+    for(n = 0; n < TOTAL / CHUNK; n++){
+      while(r->head - r->tail == NSLOT)
+        ;
+      memset(base + PGSIZE * (1 + r->head % NSLOT), n, CHUNK);
+      r->head++;
+    }
+    shmdt(base);
+    exit();
+  }
+  while(got < TOTAL){
+    while(r->head == r->tail)
+      ;
+    sum += checksum(base + PGSIZE * (1 + r->tail % NSLOT), CHUNK);
+    r->tail++;
+    got += CHUNK;
+  }
+  wait();
+  shmdt(base);
+  shmrm(id);
+  return sum == expected();
+}
+
+int
+main(int argc, char *argv[])
+{
+  int start, ok;
+
+  printf(1, "[shm bench] transfer %d KB from producer to consumer\n", TOTAL / 1024);
+
+  start = uptime();
+  ok = pipetest();
+  printf(1, "pipe: %d ticks%s\n", uptime() - start, ok ? "" : " (wrong data)");
+
+  start = uptime();
+  ok = shmtest() && ok;
+  printf(1, "shm:  %d ticks\n", uptime() - start);
+
+  if(ok)
+    printf(1, "[shm bench] done\n");
+  else
+    printf(1, "[shm bench] fail\n");
+  exit();
+}
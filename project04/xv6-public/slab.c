@@ -0,0 +1,219 @@
+// page보다 작은 kernel object를 위한 slab allocator
+// kalloc으로 받은 page 하나를 slab으로 사용하여 같은 크기의 object 여러 개를 담음
+// 각 CPU는 cache마다 magazine(free object 배열)을 가지며, 대부분의 할당과 해제는 lock 없이 magazine에서 처리하고
+// magazine이 비거나 가득 찼을 때만 cache lock을 잡고 slab과 object를 주고받음
+//
+// constructor(ctor)는 slab을 새로 만들 때 각 object에 한 번만 호출됨
+// slab_free로 돌려주는 object는 constructor를 호출한 직후의 상태여야 함 (예: lock은 release된 상태)
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "spinlock.h"
+#include "memstat.h"
+
+#define NSLABCACHE  8   // 만들 수 있는 최대 cache 수
+#define MAGSIZE     16  // magazine 하나에 담을 수 있는 object 수
+
+// CPU마다 가지는 free object 배열
+// 자신의 CPU에서만 접근하고 pushcli로 interrupt를 막은 상태에서만 사용하므로 lock이 필요 X
+struct magazine {
+  int n;
+  char *obj[MAGSIZE];
+};
+
+struct slabcache {
+  char *name;                  // 0이면 사용하지 않는 항목
+  uint size;                   // object 크기
+  uint slot;                   // slab 안에서 object 하나가 차지하는 크기
+  int perslab;                 // slab 하나의 object 수
+  void (*ctor)(void*);
+  struct spinlock lock;        // 아래의 slab list를 보호
+  struct slab *slabs;
+  int nslab;                   // slab(page) 수
+  int nfree;                   // slab list에 있는 free object 수 (magazine에 있는 object는 제외)
+  struct magazine mag[NCPU];
+};
+
+// slab page의 맨 앞에 위치
+// free object의 연결은 object 뒤의 link에 저장하여, constructor로 초기화한 object의 내용을 덮어쓰지 않음
+struct slab {
+  struct slab *next;           // 같은 cache의 slab list
+  struct slabcache *cache;
+  int inuse;                   // slab에서 꺼낸 object 수 (magazine에 있는 object 포함)
+  char *free;                  // free object list
+};
+
+static struct slabcache caches[NSLABCACHE];
+static struct spinlock cacheslock;
+
+void
+slabinit(void)
+{
+  initlock(&cacheslock, "slabcaches");
+}
+
+// size 크기의 object를 할당하는 cache를 만듦
+struct slabcache*
+slab_create(char *name, uint size, void (*ctor)(void*))
+{
+  struct slabcache *c;
+
+  acquire(&cacheslock);
+  for(c = caches; c < &caches[NSLABCACHE]; c++)
+    if(c->name == 0)
+      break;
+  if(c == &caches[NSLABCACHE])
+    panic("slab_create");
+  c->name = name;
+  c->size = size;
+  c->slot = (size + sizeof(char*) + 3) & ~3; // object + free list link, 4 byte 정렬
+  c->perslab = (PGSIZE - sizeof(struct slab)) / c->slot;
+  if(c->perslab == 0)
+    panic("slab_create: size");
+  c->ctor = ctor;
+  initlock(&c->lock, name);
+  release(&cacheslock);
+  return c;
+}
+
+// object 뒤에 저장된 free list link
+static char**
+link(struct slabcache *c, char *obj)
+{
+  return (char**)(obj + c->slot - sizeof(char*));
+}
+
+// 새로운 slab을 만들어 cache의 slab list에 추가 (c->lock을 잡은 상태에서 호출)
+static struct slab*
+slab_grow(struct slabcache *c)
+{
+  struct slab *s;
+  char *obj;
+  int i;
+
+  if((s = (struct slab*)kalloc_type(PG_SLAB)) == 0)
+    return 0;
+  s->cache = c;
+  s->inuse = 0;
+  s->free = 0;
+  for(i = c->perslab - 1; i >= 0; i--){
+    obj = (char*)(s + 1) + i*c->slot;
+    if(c->ctor)
+      c->ctor(obj);
+    *link(c, obj) = s->free;
+    s->free = obj;
+  }
+  s->next = c->slabs;
+  c->slabs = s;
+  c->nslab++;
+  c->nfree += c->perslab;
+  return s;
+}
+
+// slab list에서 object 하나를 꺼냄, 메모리가 부족하면 0을 반환 (c->lock을 잡은 상태에서 호출)
+static char*
+slab_get(struct slabcache *c)
+{
+  struct slab *s;
+  char *obj;
+
+  for(s = c->slabs; s != 0; s = s->next)
+    if(s->free)
+      break;
+  if(s == 0 && (s = slab_grow(c)) == 0)
+    return 0;
+  obj = s->free;
+  s->free = *link(c, obj);
+  s->inuse++;
+  c->nfree--;
+  return obj;
+}
+
+// object를 slab으로 돌려놓음 (c->lock을 잡은 상태에서 호출)
+// slab이 모두 비었고 다른 slab에 free object가 충분하면 page를 kalloc으로 돌려줌
+static void
+slab_put(struct slabcache *c, char *obj)
+{
+  struct slab *s = (struct slab*)PGROUNDDOWN((uint)obj), **pp;
+
+  if(s->cache != c)
+    panic("slab_put");
+  *link(c, obj) = s->free;
+  s->free = obj;
+  s->inuse--;
+  c->nfree++;
+  if(s->inuse > 0 || c->nfree - c->perslab < c->perslab)
+    return;
+  for(pp = &c->slabs; *pp != s; pp = &(*pp)->next)
+    ;
+  *pp = s->next;
+  c->nslab--;
+  c->nfree -= c->perslab;
+  kfree((char*)s);
+}
+
+// 메모리가 부족할 때 호출
+// 현재 CPU의 magazine에 있는 object를 slab으로 돌려놓고, object를 모두 돌려받은 slab의 page를 kalloc으로 돌려줌
+void
+slab_reclaim(struct slabcache *c)
+{
+  struct magazine *m;
+  struct slab *s, **pp;
+
+  pushcli();
+  m = &c->mag[cpuid()];
+  acquire(&c->lock);
+  while(m->n > 0)
+    slab_put(c, m->obj[--m->n]);
+  for(pp = &c->slabs; (s = *pp) != 0; ){
+    if(s->inuse > 0){
+      pp = &s->next;
+      continue;
+    }
+    *pp = s->next;
+    c->nslab--;
+    c->nfree -= c->perslab;
+    kfree((char*)s);
+  }
+  release(&c->lock);
+  popcli();
+}
+
+void*
+slab_alloc(struct slabcache *c)
+{
+  struct magazine *m;
+  char *obj = 0;
+
+  pushcli();
+  m = &c->mag[cpuid()];
+  if(m->n == 0){ // magazine이 비었으면 slab에서 절반을 채움
+    acquire(&c->lock);
+    while(m->n < MAGSIZE/2 && (obj = slab_get(c)) != 0)
+      m->obj[m->n++] = obj;
+    release(&c->lock);
+  }
+  obj = m->n > 0 ? m->obj[--m->n] : 0;
+  popcli();
+  return obj;
+}
+
+void
+slab_free(struct slabcache *c, void *obj)
+{
+  struct magazine *m;
+
+  pushcli();
+  m = &c->mag[cpuid()];
+  if(m->n == MAGSIZE){ // magazine이 가득 찼으면 절반을 slab으로 돌려놓음
+    acquire(&c->lock);
+    while(m->n > MAGSIZE/2)
+      slab_put(c, m->obj[--m->n]);
+    release(&c->lock);
+  }
+  m->obj[m->n++] = obj;
+  popcli();
+}
@@ -0,0 +1,58 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define PGSIZE  4096
+#define SIZE    (8*1024*1024)  // parent가 미리 할당하고 접근해두는 크기
+#define N       100
+
+int
+main(int argc, char *argv[])
+{
+  int start, fork_ticks, spawn_ticks;
+  char *p;
+  char *args[] = { "spawn_bench", "child", 0 };
+
+  if(argc > 1) // fork+exec, spawn으로 실행된 child는 바로 종료
+    exit();
+
+  if((p = sbrk(SIZE)) == (char*)-1){
+    printf(1, "sbrk failed\n");
+    exit();
+  }
+  for(int i = 0; i < SIZE / PGSIZE; i++)
+    p[i * PGSIZE] = 1;
+
+  printf(1, "[spawn bench] %d runs from a %d MB process\n", N, SIZE / (1024*1024));
+
+  start = uptime();
+  for(int i = 0; i < N; i++){
+    int pid = fork();
+    if(pid < 0){
+      printf(1, "fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      exec(args[0], args);
+      printf(1, "exec failed\n");
+      exit();
+    }
+    wait();
+  }
+  fork_ticks = uptime() - start;
+  printf(1, "fork+exec: %d ticks\n", fork_ticks);
+
+  start = uptime();
+  for(int i = 0; i < N; i++){
+    if(spawn(args[0], args, 0) < 0){
+      printf(1, "spawn failed\n");
+      exit();
+    }
+    wait();
+  }
+  spawn_ticks = uptime() - start;
+  printf(1, "spawn: %d ticks\n", spawn_ticks);
+
+  printf(1, "[spawn bench] done\n");
+  exit();
+}
@@ -0,0 +1,183 @@
+// user page를 disk의 swap 영역으로 내보내고(swap out) page fault에서 다시 읽어옴(swap in)
+// swap 영역은 fs.img에서 file system 바로 뒤(sb.swapstart)에 있으며, page 하나가 연속된 PGSIZE/BSIZE개의 block(slot)을 사용
+// swap out된 page의 PTE는 present가 아니고 PTE_SWAP이 설정되며, PTE_ADDR에 slot 번호를 저장
+// slot의 참조 횟수는 data page처럼 slot을 가리키는 page table 수로 유지 (fork로 공유한 page table을 복사하면 증가)
+//
+// swapd는 매 tick마다 free page 수를 확인하여 SWAPLOW 아래로 내려가면 SWAPHIGH까지 swap out하고,
+// 그래도 user page 할당에 실패하면 kalloc_user에서 직접 swap out (direct reclaim)
+// swap out하기 전에 먼저 buffer cache에서 사용하지 않는 buffer를 돌려받음 (disk에 write할 필요가 없음)
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "buf.h"
+#include "memstat.h"
+
+#define SLOTBLK    (PGSIZE/BSIZE)        // slot 하나의 block 수
+#define NSLOT      (NSWAPBLK/SLOTBLK)
+#define SWAPLOW    256   // free page 수가 이보다 적으면 swapd가 swap out 시작
+#define SWAPHIGH   1024  // swapd가 swap out을 멈추는 free page 수
+#define SWAPBATCH  16    // direct reclaim에서 한 번에 swap out하는 page 수
+
+extern struct superblock sb;
+
+struct {
+  struct spinlock lock;
+  uchar ref[NSLOT];   // slot을 가리키는 page table 수 (0이면 빈 slot)
+  uint hint;          // 다음 빈 slot을 찾기 시작할 위치
+  struct buf buf;     // swap I/O에 사용하는 buffer (buffer cache를 거치지 않음)
+                      // buf.lock이 swap I/O를 직렬화하므로, swap out 중인 slot을 다른 CPU가 먼저 읽지 않음
+  uint nout;          // swap out한 page 수
+  uint nin;           // swap in한 page 수
+} swap;
+
+static void swapd(void);
+
+void
+swapinit(void)
+{
+  initlock(&swap.lock, "swap");
+  initsleeplock(&swap.buf.lock, "swapbuf");
+  kthread("swapd", swapd);
+}
+
+// 빈 slot을 할당, 없으면 -1을 반환
+static int
+slot_alloc(void)
+{
+  uint nslot = sb.nswap / SLOTBLK, i, s;
+
+  acquire(&swap.lock);
+  for(i = 0; i < nslot; i++){
+    s = (swap.hint + i) % nslot;
+    if(swap.ref[s] == 0){
+      swap.ref[s] = 1;
+      swap.hint = s + 1;
+      release(&swap.lock);
+      return s;
+    }
+  }
+  release(&swap.lock);
+  return -1;
+}
+
+// slot과 mem 사이의 page 하나를 읽거나 씀 (swap.buf.lock을 잡은 상태에서 호출)
+static void
+swaprw(uint slot, char *mem, int write)
+{
+  struct buf *b = &swap.buf;
+  int i;
+
+  b->dev = ROOTDEV;
+  for(i = 0; i < SLOTBLK; i++){
+    b->blockno = sb.swapstart + slot*SLOTBLK + i;
+    if(write){
+      memmove(b->data, mem + i*BSIZE, BSIZE);
+      b->flags = B_DIRTY;
+      iderw(b);
+    } else {
+      b->flags = 0;
+      iderw(b);
+      memmove(mem + i*BSIZE, b->data, BSIZE);
+    }
+  }
+}
+
+// 최대 n개의 user page를 swap out하고 실제로 swap out한 page 수를 반환
+int
+swapout(int n)
+{
+  char *mem;
+  int i, slot;
+
+  for(i = 0; i < n; i++){
+    if((slot = slot_alloc()) < 0)
+      break;
+    acquiresleep(&swap.buf.lock);
+    if((mem = clock_evict(slot)) == 0){
+      releasesleep(&swap.buf.lock);
+      swap_free(slot);
+      break;
+    }
+    swaprw(slot, mem, 1);
+    releasesleep(&swap.buf.lock);
+    kfree(mem);
+    xadd(&swap.nout, 1);
+  }
+  return i;
+}
+
+// slot의 내용을 mem으로 읽어옴
+void
+swap_read(uint slot, char *mem)
+{
+  acquiresleep(&swap.buf.lock);
+  swaprw(slot, mem, 0);
+  releasesleep(&swap.buf.lock);
+  xadd(&swap.nin, 1);
+}
+
+void
+swap_dup(uint slot)
+{
+  acquire(&swap.lock);
+  if(swap.ref[slot] == 255)
+    panic("swap_dup");
+  swap.ref[slot]++;
+  release(&swap.lock);
+}
+
+void
+swap_free(uint slot)
+{
+  acquire(&swap.lock);
+  if(swap.ref[slot] == 0)
+    panic("swap_free");
+  swap.ref[slot]--;
+  release(&swap.lock);
+}
+
+// user memory로 사용할 page를 할당 (zero가 0이 아니면 0으로 채워진 page)
+// free page가 없으면 다른 page를 swap out하여 확보하며, swap out할 page도 없으면 0을 반환
+char*
+kalloc_user(int zero)
+{
+  char *mem;
+
+  while((mem = zero ? kalloc_zeroed(PG_USER) : kalloc_type(PG_USER)) == 0)
+    if(bshrink(SWAPBATCH) == 0 && swapout(SWAPBATCH) == 0)
+      return 0;
+  return mem;
+}
+
+// swap daemon
+// free page가 SWAPLOW보다 적어지면 SWAPHIGH가 될 때까지 미리 swap out하여, page fault에서 직접 swap out하는 일을 줄임
+static void
+swapd(void)
+{
+  for(;;){
+    acquire(&tickslock);
+    sleep(&ticks, &tickslock);
+    release(&tickslock);
+
+    if(countfp() >= SWAPLOW)
+      continue;
+    while(countfp() < SWAPHIGH)
+      if(bshrink(SWAPBATCH) == 0 && (sb.nswap == 0 || swapout(SWAPBATCH) == 0))
+        break;
+  }
+}
+
+void
+getswapstat(struct memstat *ms)
+{
+  ms->swapout = swap.nout;
+  ms->swapin = swap.nin;
+  ms->swapsize = sb.nswap / SLOTBLK;
+}
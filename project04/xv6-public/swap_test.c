@@ -0,0 +1,56 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "memstat.h"
+
+#define PGSIZE  4096
+
+// 남은 physical memory보다 큰 영역을 할당하여 모든 page에 write한 뒤 다시 읽어 내용을 확인
+// swap test [MB] : 할당할 크기 (기본값은 free memory에 swap 영역의 3/4을 더한 크기)
+int
+main(int argc, char *argv[])
+{
+  struct memstat before, after;
+  uint npages, i, *w;
+  char *p;
+  int start, write_ticks, read_ticks, bad = 0;
+
+  memstat(&before);
+  if(argc > 1)
+    npages = atoi(argv[1]) * (1024*1024 / PGSIZE);
+  else
+    npages = before.free + before.swapsize / 4 * 3;
+
+  printf(1, "[swap test] %d pages (free %d)\n", npages, before.free);
+  if((p = sbrk(npages * PGSIZE)) == (char*)-1){
+    printf(1, "sbrk failed\n");
+    exit();
+  }
+
+  start = uptime();
+  for(i = 0; i < npages; i++){
+    w = (uint*)(p + i*PGSIZE);
+    w[0] = i;
+    w[PGSIZE/sizeof(uint) - 1] = ~i;
+  }
+  write_ticks = uptime() - start;
+
+  start = uptime();
+  for(i = 0; i < npages; i++){
+    w = (uint*)(p + i*PGSIZE);
+    if(w[0] != i || w[PGSIZE/sizeof(uint) - 1] != ~i){
+      if(bad++ < 5)
+        printf(1, "page %d corrupted\n", i);
+    }
+  }
+  read_ticks = uptime() - start;
+  memstat(&after);
+
+  printf(1, "write %d ticks, verify %d ticks, swapout %d swapin %d\n",
+         write_ticks, read_ticks, after.swapout - before.swapout, after.swapin - before.swapin);
+  if(bad)
+    printf(1, "[swap test] FAILED: %d pages corrupted\n", bad);
+  else
+    printf(1, "[swap test] OK\n");
+  exit();
+}
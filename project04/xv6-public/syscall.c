@@ -6,6 +6,7 @@
 #include "proc.h"
 #include "x86.h"
 #include "syscall.h"
+#include "mman.h"
 
 // User code makes a system call with INT T_SYSCALL.
 // System call number in %eax.
@@ -13,13 +14,22 @@
 // library system call function. The saved user %esp points
 // to a saved program counter, and then the first argument.
 
+// [addr, addr+len)이 process의 [0, sz) 안에 있거나, prot 권한이 있는 mmap 영역 안에 있는지 확인
+static int
+validuser(uint addr, uint len, int prot)
+{
+  struct proc *curproc = myproc();
+
+  if(addr < curproc->sz && addr+len <= curproc->sz && addr+len >= addr)
+    return 0;
+  return vma_uaccess(curproc, addr, len, prot);
+}
+
 // Fetch the int at addr from the current process.
 int
 fetchint(uint addr, int *ip)
 {
-  struct proc *curproc = myproc();
-
-  if(addr >= curproc->sz || addr+4 > curproc->sz)
+  if(validuser(addr, 4, PROT_READ) < 0)
     return -1;
   *ip = *(int*)(addr);
   return 0;
@@ -34,15 +44,23 @@ fetchstr(uint addr, char **pp)
   char *s, *ep;
   struct proc *curproc = myproc();
 
-  if(addr >= curproc->sz)
+  if(validuser(addr, 1, PROT_READ) < 0)
+    return -1;
+  if(addr >= curproc->sz && (vma_flags(curproc, addr) & MAP_SHARED))
     return -1;
   *pp = (char*)addr;
-  ep = (char*)curproc->sz;
-  for(s = *pp; s < ep; s++){
+  ep = addr < curproc->sz ? (char*)curproc->sz : (char*)PGROUNDUP(addr + 1);
+  for(s = *pp; ; s++){
+    if(s == ep){
+      // mmap 영역의 문자열은 page마다 VMA 범위를 확인하고 mapping하면서 읽음
+      if((uint)ep <= curproc->sz || vma_uaccess(curproc, (uint)ep, 1, PROT_READ) < 0 ||
+         (vma_flags(curproc, (uint)ep) & MAP_SHARED))
+        return -1;
+      ep += PGSIZE;
+    }
     if(*s == 0)
       return s - *pp;
   }
-  return -1;
 }
 
 // Fetch the nth 32-bit system call argument.
@@ -59,11 +77,24 @@ int
 argptr(int n, char **pp, int size)
 {
   int i;
-  struct proc *curproc = myproc();
  
   if(argint(n, &i) < 0)
     return -1;
-  if(size < 0 || (uint)i >= curproc->sz || (uint)i+size > curproc->sz)
+  if(size < 0 || validuser(i, size, PROT_READ) < 0)
+    return -1;
+  *pp = (char*)i;
+  return 0;
+}
+
+// argptr과 같지만 kernel이 결과를 write할 buffer이므로, mmap 영역이면 PROT_WRITE도 확인
+int
+argwptr(int n, char **pp, int size)
+{
+  int i;
+ 
+  if(argint(n, &i) < 0)
+    return -1;
+  if(size < 0 || validuser(i, size, PROT_WRITE) < 0)
     return -1;
   *pp = (char*)i;
   return 0;
@@ -71,8 +102,8 @@ argptr(int n, char **pp, int size)
 
 // Fetch the nth word-sized system call argument as a string pointer.
 // Check that the pointer is valid and the string is nul-terminated.
-// (There is no shared writable memory, so the string can't change
-// between this check and being used by the kernel.)
+// (다른 process가 write할 수 있는 MAP_SHARED 영역의 문자열은 받지 않으므로,
+// the string can't change between this check and being used by the kernel.)
 int
 argstr(int n, char **pp)
 {
@@ -107,6 +138,20 @@ extern int sys_countfp(void);
 extern int sys_countvp(void);
 extern int sys_countpp(void);
 extern int sys_countptp(void);
+extern int sys_memstat(void);
+extern int sys_spawn(void);
+extern int sys_hugepage(void);
+extern int sys_mmap(void);
+extern int sys_munmap(void);
+extern int sys_shmget(void);
+extern int sys_shmat(void);
+extern int sys_shmdt(void);
+extern int sys_shmrm(void);
+extern int sys_ksm(void);
+extern int sys_procmem(void);
+extern int sys_memlimit(void);
+extern int sys_fsync(void);
+extern int sys_commitivl(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -134,6 +179,20 @@ static int (*syscalls[])(void) = {
 [SYS_countvp] sys_countvp,
 [SYS_countpp] sys_countpp,
 [SYS_countptp] sys_countptp,
+[SYS_memstat] sys_memstat,
+[SYS_spawn]   sys_spawn,
+[SYS_hugepage] sys_hugepage,
+[SYS_mmap]    sys_mmap,
+[SYS_munmap]  sys_munmap,
+[SYS_shmget]  sys_shmget,
+[SYS_shmat]   sys_shmat,
+[SYS_shmdt]   sys_shmdt,
+[SYS_shmrm]   sys_shmrm,
+[SYS_ksm]     sys_ksm,
+[SYS_procmem] sys_procmem,
+[SYS_memlimit] sys_memlimit,
+[SYS_fsync]   sys_fsync,
+[SYS_commitivl] sys_commitivl,
 };
 
 void
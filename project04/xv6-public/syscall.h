@@ -24,3 +24,17 @@
 #define SYS_countvp 23
 #define SYS_countpp 24
 #define SYS_countptp 25
+#define SYS_memstat 26
+#define SYS_spawn  27
+#define SYS_hugepage 28
+#define SYS_mmap   29
+#define SYS_munmap 30
+#define SYS_shmget 31
+#define SYS_shmat  32
+#define SYS_shmdt  33
+#define SYS_shmrm  34
+#define SYS_ksm    35
+#define SYS_procmem 36
+#define SYS_memlimit 37
+#define SYS_fsync  38
+#define SYS_commitivl 39
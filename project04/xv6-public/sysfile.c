@@ -15,6 +15,7 @@
 #include "sleeplock.h"
 #include "file.h"
 #include "fcntl.h"
+#include "mman.h"
 
 // Fetch the nth word-sized system call argument as a file descriptor
 // and return both the descriptor and the corresponding struct file.
@@ -73,7 +74,7 @@ sys_read(void)
   int n;
   char *p;
 
-  if(argfd(0, 0, &f) < 0 || argint(2, &n) < 0 || argptr(1, &p, n) < 0)
+  if(argfd(0, 0, &f) < 0 || argint(2, &n) < 0 || argwptr(1, &p, n) < 0)
     return -1;
   return fileread(f, p, n);
 }
@@ -109,7 +110,7 @@ sys_fstat(void)
   struct file *f;
   struct stat *st;
 
-  if(argfd(0, 0, &f) < 0 || argptr(1, (void*)&st, sizeof(*st)) < 0)
+  if(argfd(0, 0, &f) < 0 || argwptr(1, (void*)&st, sizeof(*st)) < 0)
     return -1;
   return filestat(f, st);
 }
@@ -393,19 +394,18 @@ sys_chdir(void)
   return 0;
 }
 
-int
-sys_exec(void)
+// n번째 system call 인자로 전달된 user argv 배열을 argv에 가져옴
+static int
+argargv(int n, char **argv)
 {
-  char *path, *argv[MAXARG];
   int i;
   uint uargv, uarg;
 
-  if(argstr(0, &path) < 0 || argint(1, (int*)&uargv) < 0){
+  if(argint(n, (int*)&uargv) < 0)
     return -1;
-  }
-  memset(argv, 0, sizeof(argv));
+  memset(argv, 0, MAXARG*sizeof(argv[0]));
   for(i=0;; i++){
-    if(i >= NELEM(argv))
+    if(i >= MAXARG)
       return -1;
     if(fetchint(uargv+4*i, (int*)&uarg) < 0)
       return -1;
@@ -416,9 +416,49 @@ sys_exec(void)
     if(fetchstr(uarg, &argv[i]) < 0)
       return -1;
   }
+  return 0;
+}
+
+int
+sys_exec(void)
+{
+  char *path, *argv[MAXARG];
+
+  if(argstr(0, &path) < 0 || argargv(1, argv) < 0){
+    return -1;
+  }
   return exec(path, argv);
 }
 
+// spawn(path, argv, fds): fds가 0이면 child의 fd 0~2는 parent의 fd 0~2를 그대로 사용하고,
+// 아니면 child의 fd i는 parent의 fd fds[i]가 됨 (-1이면 닫힌 상태)
+int
+sys_spawn(void)
+{
+  char *path, *argv[MAXARG];
+  int i, *fds;
+  uint ufds;
+  struct file *f[3];
+  struct proc *curproc = myproc();
+
+  if(argstr(0, &path) < 0 || argargv(1, argv) < 0 || argint(2, (int*)&ufds) < 0)
+    return -1;
+  if(ufds == 0){
+    for(i = 0; i < 3; i++)
+      f[i] = curproc->ofile[i];
+  } else {
+    if(argptr(2, (char**)&fds, 3*sizeof(int)) < 0)
+      return -1;
+    for(i = 0; i < 3; i++){
+      if(fds[i] == -1)
+        f[i] = 0;
+      else if(fds[i] < 0 || fds[i] >= NOFILE || (f[i] = curproc->ofile[fds[i]]) == 0)
+        return -1;
+    }
+  }
+  return spawn(path, argv, f);
+}
+
 int
 sys_pipe(void)
 {
@@ -426,7 +466,7 @@ sys_pipe(void)
   struct file *rf, *wf;
   int fd0, fd1;
 
-  if(argptr(0, (void*)&fd, 2*sizeof(fd[0])) < 0)
+  if(argwptr(0, (void*)&fd, 2*sizeof(fd[0])) < 0)
     return -1;
   if(pipealloc(&rf, &wf) < 0)
     return -1;
@@ -442,3 +482,56 @@ sys_pipe(void)
   fd[1] = fd1;
   return 0;
 }
+
+// mmap(addr, len, prot, flags, fd, off): addr는 사용하지 않고 kernel이 빈 영역을 골라 시작 주소를 반환
+int
+sys_mmap(void)
+{
+  int len, prot, flags, fd, off;
+  struct file *f = 0;
+  uint addr;
+
+  if(argint(1, &len) < 0 || argint(2, &prot) < 0 || argint(3, &flags) < 0 ||
+     argint(4, &fd) < 0 || argint(5, &off) < 0)
+    return -1;
+  if(len <= 0 || off < 0)
+    return -1;
+  if(!(flags & MAP_ANONYMOUS) && argfd(4, 0, &f) < 0)
+    return -1;
+  if((addr = mmap(len, prot, flags, f, off)) == 0)
+    return -1;
+  return addr;
+}
+
+int
+sys_munmap(void)
+{
+  int addr, len;
+
+  if(argint(0, &addr) < 0 || argint(1, &len) < 0 || len <= 0)
+    return -1;
+  return munmap(addr, len);
+}
+
+// fsync(fd): 이미 끝난 FS system call의 변경 내용이 disk에 기록될 때까지 기다림
+int
+sys_fsync(void)
+{
+  struct file *f;
+
+  if(argfd(0, 0, &f) < 0)
+    return -1;
+  log_sync();
+  return 0;
+}
+
+// commitivl(ticks): log transaction의 commit 주기를 설정하고 이전 값을 반환 (음수면 바꾸지 않음)
+int
+sys_commitivl(void)
+{
+  int interval;
+
+  if(argint(0, &interval) < 0)
+    return -1;
+  return log_interval(interval);
+}
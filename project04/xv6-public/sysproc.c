@@ -6,6 +6,7 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "memstat.h"
 
 int
 sys_fork(void)
@@ -112,4 +113,109 @@ int
 sys_countptp(void)
 {
   return countptp();
-}
\ No newline at end of file
+}
+
+int
+sys_memstat(void)
+{
+  struct memstat *ms;
+
+  if(argwptr(0, (void*)&ms, sizeof(*ms)) < 0)
+    return -1;
+  getmemstat(ms);
+  return 0;
+}
+
+// hugepage(on): on이 0이 아니면 이후 heap의 4MB 영역을 hugepage로 mapping, 이전 설정을 반환
+int
+sys_hugepage(void)
+{
+  int on, old;
+
+  if(argint(0, &on) < 0)
+    return -1;
+  old = myproc()->hugepage;
+  myproc()->hugepage = (on != 0);
+  return old;
+}
+
+// ksm(on): on이 0이 아니면 ksmd가 이 process(와 이후 fork한 child)에서 같은 내용의 page를 합치도록 함, 이전 설정을 반환
+int
+sys_ksm(void)
+{
+  int on, old;
+
+  if(argint(0, &on) < 0)
+    return -1;
+  old = myproc()->ksm;
+  myproc()->ksm = (on != 0);
+  return old;
+}
+
+// procmem(pid, pm): pid인 process의 memory 사용량을 pm에 복사
+int
+sys_procmem(void)
+{
+  struct procmem *pm;
+  int pid;
+
+  if(argint(0, &pid) < 0 || argwptr(1, (void*)&pm, sizeof(*pm)) < 0)
+    return -1;
+  return getprocmem(pid, pm);
+}
+
+// memlimit(pid, npages): pid인 process가 혼자 사용할 수 있는 page 수를 제한 (0이면 제한 없음), 이전 값을 반환
+int
+sys_memlimit(void)
+{
+  int pid, limit;
+
+  if(argint(0, &pid) < 0 || argint(1, &limit) < 0)
+    return -1;
+  return setmemlimit(pid, limit);
+}
+
+// shmget(key, size): key에 해당하는 shared memory segment의 id를 반환 (없으면 새로 만듦)
+int
+sys_shmget(void)
+{
+  int key, size;
+
+  if(argint(0, &key) < 0 || argint(1, &size) < 0 || size <= 0)
+    return -1;
+  return shmget(key, size);
+}
+
+// shmat(id): segment를 attach한 주소를 반환
+int
+sys_shmat(void)
+{
+  int id;
+  uint addr;
+
+  if(argint(0, &id) < 0)
+    return -1;
+  if((addr = shmat(id)) == 0)
+    return -1;
+  return addr;
+}
+
+int
+sys_shmdt(void)
+{
+  int addr;
+
+  if(argint(0, &addr) < 0)
+    return -1;
+  return shmdt(addr);
+}
+
+int
+sys_shmrm(void)
+{
+  int id;
+
+  if(argint(0, &id) < 0)
+    return -1;
+  return shmrm(id);
+}
@@ -17,7 +17,8 @@ main(int argc, char* argv[])
   // printf(1, "before pp : %d\n\n", numpp);
   // printf(1, "before ptp : %d\n\n", numptp);
 
-  sbrk(4096);
+  char *p = sbrk(4096);
+  p[0] = 1;  // sbrk는 lazy하게 page를 할당하므로, 접근해야 physical page가 할당됨
 
   int numfpa = countfp();
   int numvpa = countvp();
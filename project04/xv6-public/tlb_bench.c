@@ -0,0 +1,60 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define PGSIZE  4096
+#define NPAGES  4096  // 16MB working set
+#define ROUNDS  20
+
+char *buf;
+
+// working set의 모든 page를 한 번씩 읽음
+int
+sweep(void)
+{
+  int sum = 0;
+
+  for(int i = 0; i < NPAGES; i++)
+    sum += buf[i * PGSIZE];
+  return sum;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int start, elapsed, sum = 0;
+
+  printf(1, "[TLB bench] post-fork TLB refill on %d MB working set\n", NPAGES * PGSIZE / (1024*1024));
+
+  buf = sbrk(NPAGES * PGSIZE);
+  for(int i = 0; i < NPAGES; i++)
+    buf[i * PGSIZE] = 1;
+
+  // fork 없이 working set을 write + read 하는 기준 시간
+  start = uptime();
+  for(int r = 0; r < ROUNDS; r++){
+    for(int i = 0; i < NPAGES; i++)
+      buf[i * PGSIZE] = r;
+    sum += sweep();
+  }
+  elapsed = uptime() - start;
+  printf(1, "no fork:    %d ticks\n", elapsed);
+
+  // fork 후 parent의 모든 page가 write-protect되므로, write할 때마다 page fault(CoW)가 발생
+  // page fault마다 TLB 전체를 flush하면 이후 접근에서 TLB miss가 working set 크기만큼 발생
+  start = uptime();
+  for(int r = 0; r < ROUNDS; r++){
+    if(fork() == 0)
+      exit();
+    wait();
+    for(int i = 0; i < NPAGES; i++)
+      buf[i * PGSIZE] = r;
+    sum += sweep();
+  }
+  elapsed = uptime() - start;
+  printf(1, "after fork: %d ticks\n", elapsed);
+
+  printf(1, "[TLB bench] done (%d)\n", sum);
+
+  exit();
+}
@@ -78,8 +78,9 @@ trap(struct trapframe *tf)
     lapiceoi();
     break;
   case T_PGFLT:   // pagefault 발생 시 handler가 호출되도록 case 추가
-    CoW_handler();
-    break;
+    if(pgfault_handler(tf->err) == 0)
+      break;
+    // 처리할 수 없는 page fault는 default와 동일하게 처리 (kernel이면 panic, user process면 kill)
 
   //PAGEBREAK: 13
   default:
@@ -1,5 +1,7 @@
 struct stat;
 struct rtcdate;
+struct memstat;
+struct procmem;
 
 // system calls
 int fork(void);
@@ -27,6 +29,20 @@ int countfp(void);
 int countvp(void);
 int countpp(void);
 int countptp(void);
+int memstat(struct memstat*);
+int spawn(char*, char**, int*);
+int hugepage(int);
+void* mmap(void*, int, int, int, int, int);
+int munmap(void*, int);
+int shmget(int, int);
+void* shmat(int);
+int shmdt(void*);
+int shmrm(int);
+int ksm(int);
+int procmem(int, struct procmem*);
+int memlimit(int, int);
+int fsync(int);
+int commitivl(int);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -6,9 +6,54 @@
 #include "mmu.h"
 #include "proc.h"
 #include "elf.h"
+#include "memstat.h"
+#include "mman.h"
 
 extern char data[];  // defined by kernel.ld
 pde_t *kpgdir;  // for use in scheduler()
+char *zeropage;  // 아직 write하지 않은 anonymous memory가 read-only로 공유하는 0으로 채워진 page
+
+static int pgtab_unshare(pde_t*, uint);
+static void pgtab_release(pte_t*);
+static int hugepage_split(pde_t*, uint);
+
+// pgdir이 현재 process의 page table이면 현재 process를, 아니면 0을 반환
+// exec에서 만드는 중이거나 wait에서 free하는 page table의 변경은 memory counter에 반영하지 않음
+static struct proc*
+acctproc(pde_t *pgdir)
+{
+  struct proc *p;
+
+  if(kpgdir == 0) // kvmalloc에서 kpgdir을 만드는 중이면 아직 mpinit 전이라 myproc()를 호출할 수 없음
+    return 0;
+  p = myproc();
+  return (p && p->pgdir == pgdir) ? p : 0;
+}
+
+// PDE pde 아래의 PTE pte를 mapping(n = 1)하거나 해제(n = -1)할 때 p의 memory counter를 갱신
+// MAP_SHARED가 아니면서 PTE나 PDE가 read-only인 page(fork로 공유한 page table 포함)는 CoW page로 셈
+// 실행 중인 process는 자신의 counter만 바꾸므로 xadd로 갱신하고,
+// 다른 process의 counter는 그 process가 실행 중이 아닐 때 ptable.lock을 잡고 바꿈 (clock_evict, ksm_page)
+static void
+acctpte(struct proc *p, pde_t pde, pte_t pte, int n)
+{
+  if(p == 0 || !(pte & PTE_P))
+    return;
+  xadd(&p->rss, n);
+  if(pte & PTE_SHARED)
+    xadd(&p->shmpg, n);
+  else if(!(pte & PTE_W) || !(pde & PTE_W))
+    xadd(&p->cowpg, n);
+  if(p->rss > p->maxrss)
+    p->maxrss = p->rss;
+}
+
+// p가 혼자 사용하는 page를 n개 늘리면 memory limit을 넘는지 확인
+static int
+overlimit(struct proc *p, uint n)
+{
+  return p && p->memlimit && p->rss - p->cowpg - p->shmpg + n > p->memlimit;
+}
 
 // Set up CPU's kernel segment descriptors.
 // Run once on entry on each CPU.
@@ -37,19 +82,23 @@ walkpgdir(pde_t *pgdir, const void *va, int alloc)
 {
   pde_t *pde;
   pte_t *pgtab;
+  struct proc *p;
 
   pde = &pgdir[PDX(va)];
+  if(*pde & PTE_PS) // 4MB hugepage에는 page table이 없으므로 호출한 쪽에서 먼저 처리해야 함
+    panic("walkpgdir: hugepage");
   if(*pde & PTE_P){
     pgtab = (pte_t*)P2V(PTE_ADDR(*pde));
   } else {
-    if(!alloc || (pgtab = (pte_t*)kalloc()) == 0)
-      return 0;
     // Make sure all those PTE_P bits are zero.
-    memset(pgtab, 0, PGSIZE);
+    if(!alloc || (pgtab = (pte_t*)kalloc_zeroed(PG_PGTAB)) == 0)
+      return 0;
     // The permissions here are overly generous, but they can
     // be further restricted by the permissions in the page table
     // entries, if necessary.
     *pde = V2P(pgtab) | PTE_P | PTE_W | PTE_U;
+    if((p = acctproc(pgdir)) != 0)
+      xadd(&p->ptpg, 1);
   }
   return &pgtab[PTX(va)];
 }
@@ -62,6 +111,7 @@ mappages(pde_t *pgdir, void *va, uint size, uint pa, int perm)
 {
   char *a, *last;
   pte_t *pte;
+  struct proc *p = acctproc(pgdir);
 
   a = (char*)PGROUNDDOWN((uint)va);
   last = (char*)PGROUNDDOWN(((uint)va) + size - 1);
@@ -71,6 +121,7 @@ mappages(pde_t *pgdir, void *va, uint size, uint pa, int perm)
     if(*pte & PTE_P)
       panic("remap");
     *pte = pa | perm | PTE_P;
+    acctpte(p, pgdir[PDX(a)], *pte, 1);
     if(a == last)
       break;
     a += PGSIZE;
@@ -121,9 +172,8 @@ setupkvm(void)
   pde_t *pgdir;
   struct kmap *k;
 
-  if((pgdir = (pde_t*)kalloc()) == 0)
+  if((pgdir = (pde_t*)kalloc_zeroed(PG_PGTAB)) == 0)
     return 0;
-  memset(pgdir, 0, PGSIZE);
   if (P2V(PHYSTOP) > (void*)DEVSPACE)
     panic("PHYSTOP too high");
   for(k = kmap; k < &kmap[NELEM(kmap)]; k++)
@@ -142,6 +192,11 @@ kvmalloc(void)
 {
   kpgdir = setupkvm();
   switchkvm();
+
+  // zero page는 kalloc으로 받은 참조(1)를 계속 유지하므로 참조 횟수가 0이 되어 free되지 않음
+  if((zeropage = kalloc()) == 0)
+    panic("kvmalloc: zeropage");
+  memset(zeropage, 0, PGSIZE);
 }
 
 // Switch h/w page table register to the kernel-only page table,
@@ -186,8 +241,7 @@ inituvm(pde_t *pgdir, char *init, uint sz)
 
   if(sz >= PGSIZE)
     panic("inituvm: more than a page");
-  mem = kalloc();
-  memset(mem, 0, PGSIZE);
+  mem = kalloc_zeroed(PG_USER);
   mappages(pgdir, 0, PGSIZE, V2P(mem), PTE_W|PTE_U);
   memmove(mem, init, sz);
 }
@@ -228,16 +282,19 @@ allocuvm(pde_t *pgdir, uint oldsz, uint newsz)
     return 0;
   if(newsz < oldsz)
     return oldsz;
+  if(overlimit(acctproc(pgdir), (PGROUNDUP(newsz) - PGROUNDUP(oldsz)) / PGSIZE)){
+    cprintf("allocuvm: memory limit exceeded\n");
+    return 0;
+  }
 
   a = PGROUNDUP(oldsz);
   for(; a < newsz; a += PGSIZE){
-    mem = kalloc();
+    mem = kalloc_user(1);
     if(mem == 0){
       cprintf("allocuvm out of memory\n");
       deallocuvm(pgdir, newsz, oldsz);
       return 0;
     }
-    memset(mem, 0, PGSIZE);
     if(mappages(pgdir, (char*)a, PGSIZE, V2P(mem), PTE_W|PTE_U) < 0){
       cprintf("allocuvm out of memory (2)\n");
       deallocuvm(pgdir, newsz, oldsz);
@@ -248,21 +305,52 @@ allocuvm(pde_t *pgdir, uint oldsz, uint newsz)
   return newsz;
 }
 
-// Deallocate user pages to bring the process size from oldsz to
-// newsz.  oldsz and newsz need not be page-aligned, nor does newsz
-// need to be less than oldsz.  oldsz can be larger than the actual
-// process size.  Returns the new process size.
-int
-deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
+// deallocuvm에서 호출하여 실제로 page를 해제
+static int
+deallocpages(pde_t *pgdir, uint oldsz, uint newsz)
 {
-  pte_t *pte;
+  pte_t *pte, *pgtab;
   uint a, pa;
+  struct proc *p = acctproc(pgdir);
+  int i;
 
   if(newsz >= oldsz)
     return oldsz;
 
   a = PGROUNDUP(newsz);
+  // newsz가 속한 page table은 일부만 해제하므로, fork로 공유 중이라면 먼저 복사
+  // 4MB hugepage인 경우에도 일부만 해제할 수 있도록 먼저 4KB page들로 나눔
+  if(a % HUGEPGSIZE != 0 && (hugepage_split(pgdir, a) < 0 || pgtab_unshare(pgdir, a) < 0))
+    return 0;
   for(; a  < oldsz; a += PGSIZE){
+    // oldsz가 속한 4MB 영역은 앞부분만 해제하므로(munmap), 마찬가지로 먼저 나누거나 복사
+    if(a % HUGEPGSIZE == 0 && a + HUGEPGSIZE > oldsz &&
+       (hugepage_split(pgdir, a) < 0 || pgtab_unshare(pgdir, a) < 0))
+      return 0;
+    if(a % HUGEPGSIZE == 0 && (pgdir[PDX(a)] & PTE_PS)){ // 4MB 영역 전체를 해제하므로 hugepage를 그대로 돌려놓음
+      kfree_huge(P2V(PTE_ADDR(pgdir[PDX(a)])));
+      pgdir[PDX(a)] = 0;
+      if(p)
+        xadd(&p->rss, -NPTENTRIES);
+      a += HUGEPGSIZE - PGSIZE;
+      continue;
+    }
+    if(a % (NPTENTRIES * PGSIZE) == 0 && (pgdir[PDX(a)] & PTE_P) && !(pgdir[PDX(a)] & PTE_W)){
+      // fork로 공유 중인 page table 전체를 해제하는 경우,
+      // data page의 참조 횟수는 page table 단위로 유지되므로 page table의 참조만 놓고,
+      // 마지막 참조였을 때만 data page와 swap slot의 참조를 놓음
+      pgtab = (pte_t*)P2V(PTE_ADDR(pgdir[PDX(a)]));
+      if(p){
+        for(i = 0; i < NPTENTRIES; i++)
+          acctpte(p, pgdir[PDX(a)], pgtab[i], -1);
+        xadd(&p->ptpg, -1);
+      }
+      if(decr_refc(V2P(pgtab)) == 0)
+        pgtab_release(pgtab);
+      pgdir[PDX(a)] = 0;
+      a = PGADDR(PDX(a) + 1, 0, 0) - PGSIZE;
+      continue;
+    }
     pte = walkpgdir(pgdir, (char*)a, 0);
     if(!pte)
       a = PGADDR(PDX(a) + 1, 0, 0) - PGSIZE;
@@ -271,13 +359,37 @@ deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
       if(pa == 0)
         panic("kfree");
       char *v = P2V(pa);
+      acctpte(p, pgdir[PDX(a)], *pte, -1);
       kfree(v);
       *pte = 0;
+    } else if(*pte & PTE_SWAP){ // swap out된 page는 swap slot의 참조를 놓음
+      swap_free(PTE_ADDR(*pte) >> PTXSHIFT);
+      *pte = 0;
     }
   }
   return newsz;
 }
 
+// Deallocate user pages to bring the process size from oldsz to
+// newsz.  oldsz and newsz need not be page-aligned, nor does newsz
+// need to be less than oldsz.  oldsz can be larger than the actual
+// process size.  Returns the new process size.
+// 현재 process의 page table이면 해제하는 동안 ptbusy를 올려,
+// swapd와 ksmd가 kfree 중인 PTE를 swap out하거나 합치지 않도록 함
+int
+deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
+{
+  struct proc *p = acctproc(pgdir);
+  int sz;
+
+  if(p)
+    p->ptbusy++;
+  sz = deallocpages(pgdir, oldsz, newsz);
+  if(p)
+    p->ptbusy--;
+  return sz;
+}
+
 // Free a page table and all the physical memory pages
 // in the user part.
 void
@@ -312,51 +424,205 @@ clearpteu(pde_t *pgdir, char *uva)
 
 // Given a parent process's page table, create a copy
 // of it for a child.
+// sz 위의 mmap 영역도 공유해야 하므로 KERNBASE 아래의 모든 user 영역을 순회
+// user 영역의 page table(second-level)은 복사하지 않고 parent와 child가 공유
+// PDE의 Writeable flag를 disable하여 4MB 영역 전체를 read-only로 만들고,
+// 처음 write가 발생할 때 pgtab_unshare()에서 page table을 복사
 pde_t*
 copyuvm(pde_t *pgdir, uint sz)
 {
   pde_t *d;
-  pte_t *pte;
-  uint pa, i, flags;
-  // char *mem;
+  uint i;
+  int changed = 0;
+  struct proc *p;
 
   if((d = setupkvm()) == 0)
     return 0;
-  for(i = 0; i < sz; i += PGSIZE){
-    if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0)
-      panic("copyuvm: pte should exist");
-    if(!(*pte & PTE_P))
-      panic("copyuvm: page not present");
-
-    *pte = *pte & (~PTE_W); // Writeable flag를 disable (PTE_W의 bit를 반전시켜서 and 연산으로 Writeable bit만 0으로 설정)
-    pa = PTE_ADDR(*pte);
-    flags = PTE_FLAGS(*pte);
-    
-    // Child process는 새로운 page를 복사하여 할당받지 않기 때문에, 아래의 기존 코드 주석 처리
-    // if((mem = kalloc()) == 0)
-    //   goto bad;
-    // memmove(mem, (char*)P2V(pa), PGSIZE);
-    // if(mappages(d, (void*)i, PGSIZE, V2P(mem), flags) < 0) {
-    //   kfree(mem);
-    //   goto bad;
-    // }
-
-    if(mappages(d, (void*)i, PGSIZE, pa, flags) < 0){ // pa는 이미 physical address이기 때문에 V2P(pa)로 argument 전달할 필요 X
-      // kfree((char*)pa); // kalloc을 여기서 해주지 않기 때문에 kfree를 해줄 필요 X
-      goto bad;
+  // 4MB hugepage는 공유하지 않고 4KB page들로 나눈 뒤 다른 page table처럼 공유
+  // 실패했을 때 parent의 PDE가 일부만 read-only로 바뀌지 않도록, PDE를 바꾸기 전에 모두 나눔
+  for(i = 0; i < KERNBASE; i += HUGEPGSIZE){
+    if(!(pgdir[PDX(i)] & PTE_PS))
+      continue;
+    changed = 1;
+    if(hugepage_split(pgdir, i) < 0){
+      freevm(d);
+      lcr3(V2P(pgdir));
+      return 0;
     }
-
-    incr_refc(pa);  // copyuvm을 통해 page를 공유하였다면, 해당 page에 대한 참조 횟수를 증가
+  }
+  for(i = 0; i < KERNBASE; i = PGADDR(PDX(i) + 1, 0, 0)){
+    if(!(pgdir[PDX(i)] & PTE_P)) // 아직 page table이 없는 영역은 건너뜀
+      continue;
+    if(pgdir[PDX(i)] & PTE_W){
+      pgdir[PDX(i)] &= ~PTE_W;
+      changed = 1;
+    }
+    d[PDX(i)] = pgdir[PDX(i)];
+    incr_refc(PTE_ADDR(pgdir[PDX(i)])); // page table page의 참조 횟수를 증가 (data page의 참조 횟수는 page table 단위로 유지)
   }
 
-  lcr3(V2P(pgdir)); // Parent process의 page table entry의 flag가 변경되었기 때문에 CR3 레지스터에 새로운 pgdir을 업데이트시켜줌
+  if(changed) // Parent process의 PDE가 변경되었기 때문에 4MB 영역 전체의 TLB entry를 무효화해야 하므로 TLB flush
+    lcr3(V2P(pgdir));
+  if((p = acctproc(pgdir)) != 0) // 모든 PDE가 read-only가 되었으므로 MAP_SHARED가 아닌 page는 모두 CoW page
+    p->cowpg = p->rss - p->shmpg;
   return d;
+}
+
+// pgdir에서 va가 속한 page table이 fork로 공유 중(PDE가 read-only)이면, PTE를 변경하기 전에 혼자 사용하도록 만듦
+// 다른 page directory가 아직 참조하고 있으면 page table을 복사하고, 그 안의 data page들은 page 단위 CoW로 공유
+// 성공하면 0, 메모리가 부족하면 -1을 반환
+static int
+pgtab_unshare(pde_t *pgdir, uint va)
+{
+  pde_t *pde;
+  pte_t *old, *new;
+  struct proc *p;
+  int i;
+
+  pde = &pgdir[PDX(va)];
+  if(!(*pde & PTE_P) || (*pde & PTE_W)) // 공유 중인 page table이 아님
+    return 0;
+
+  old = (pte_t*)P2V(PTE_ADDR(*pde));
+  if(get_refc(V2P(old)) == 1){ // 공유하던 다른 page directory가 모두 떠났으므로 PDE의 Writeable flag만 다시 설정
+    if((p = acctproc(pgdir)) != 0) // writable PTE의 page는 더 이상 CoW page가 아님
+      for(i = 0; i < NPTENTRIES; i++)
+        if((old[i] & (PTE_P|PTE_W)) == (PTE_P|PTE_W) && !(old[i] & PTE_SHARED))
+          xadd(&p->cowpg, -1);
+    *pde |= PTE_W;
+    return 0;
+  }
 
-bad:
-  freevm(d);
+  if((new = (pte_t*)kalloc_type(PG_PGTAB)) == 0)
+    return -1;
+  for(i = 0; i < NPTENTRIES; i++){
+    if(old[i] & PTE_P){
+      // 이제 두 page table이 같은 data page를 가리키므로, 양쪽 모두 read-only로 만들어 page 단위 CoW로 처리
+      // (old를 사용하는 다른 process는 PDE가 read-only이므로 TLB에도 read-only로만 남아있음)
+      // MAP_SHARED page는 CoW로 만들지 않고 writable인 채로 공유
+      if(!(old[i] & PTE_SHARED))
+        old[i] &= ~PTE_W;
+      incr_refc(PTE_ADDR(old[i]));
+    } else if(old[i] & PTE_SWAP){ // swap out된 page는 swap slot을 두 page table이 공유
+      swap_dup(PTE_ADDR(old[i]) >> PTXSHIFT);
+    }
+    new[i] = old[i];
+  }
+  *pde = V2P(new) | PTE_P | PTE_W | PTE_U;
+  // 공유하던 page table의 참조 횟수 감소
+  // 위에서 get_refc를 확인한 뒤 다른 process도 동시에 복사하거나 떠났다면 여기서 마지막 참조가 될 수 있으므로,
+  // 감소와 확인을 원자적으로 하여 old가 가지고 있던 참조를 놓음
+  if(decr_refc(V2P(old)) == 0)
+    pgtab_release(old);
   return 0;
 }
 
+// 참조 횟수가 0이 된 공유 page table을 free
+// page table이 가지고 있던 data page와 swap slot의 참조를 놓음
+static void
+pgtab_release(pte_t *pgtab)
+{
+  int i;
+
+  for(i = 0; i < NPTENTRIES; i++){
+    if(pgtab[i] & PTE_P)
+      kfree(P2V(PTE_ADDR(pgtab[i])));
+    else if(pgtab[i] & PTE_SWAP)
+      swap_free(PTE_ADDR(pgtab[i]) >> PTXSHIFT);
+  }
+  incr_refc(V2P(pgtab)); // kfree가 참조 횟수를 다시 감소시키므로 1로 되돌림
+  kfree((char*)pgtab);
+}
+
+// mmap, shm 영역의 page 하나(mem)를 현재 process의 pgdir에서 va에 perm으로 mapping
+// fork로 공유 중인 page table이면 먼저 복사하며, 실패하면 -1을 반환
+int
+mapuserpage(pde_t *pgdir, uint va, char *mem, int perm)
+{
+  if((pgdir[PDX(va)] & PTE_P) && !(pgdir[PDX(va)] & PTE_W)){
+    if(pgtab_unshare(pgdir, va) < 0)
+      return -1;
+    lcr3(V2P(pgdir)); // PDE가 변경되었으므로 4MB 영역 전체의 TLB entry를 무효화
+  }
+  return mappages(pgdir, (char*)va, PGSIZE, V2P(mem), perm);
+}
+
+// va의 PTE를 반환하되, page table이 없거나 fork로 공유 중이거나 hugepage이면 0을 반환
+// (PTE를 바꾸어도 다른 page directory에 영향을 주지 않는 경우에만 PTE를 반환)
+pte_t*
+privpte(pde_t *pgdir, uint va)
+{
+  pde_t pde = pgdir[PDX(va)];
+
+  if(!(pde & PTE_P) || !(pde & PTE_W) || (pde & PTE_PS))
+    return 0;
+  return walkpgdir(pgdir, (char*)va, 0);
+}
+
+// uva에 mapping된 user page가 mapping된 뒤 write되었는지(Dirty bit) 확인
+int
+ptedirty(pde_t *pgdir, char *uva)
+{
+  pte_t *pte;
+
+  if(!(pgdir[PDX(uva)] & PTE_P) || (pgdir[PDX(uva)] & PTE_PS))
+    return 0;
+  pte = walkpgdir(pgdir, uva, 0);
+  return pte != 0 && (*pte & PTE_P) && (*pte & PTE_D);
+}
+
+// clock_evict에서 va의 page가 swap out할 수 있는 page인지 확인
+// -1: va가 속한 4MB 영역 전체를 건너뜀 (page table이 없거나, fork로 공유 중이거나, hugepage)
+//  0: swap out할 수 없는 page (mapping되지 않았거나, read-only, MAP_SHARED, 여러 process가 공유하는 page)
+//  1: 최근에 접근한 page이므로 Accessed bit만 지우고 한 번 더 기회를 줌
+//  2: swap out할 page
+// ptable.lock을 잡은 상태에서 호출하므로 해당 process는 다른 CPU에서 실행 중이 아님
+int
+swap_check(pde_t *pgdir, uint va)
+{
+  pde_t pde = pgdir[PDX(va)];
+  pte_t *pte;
+
+  if(!(pde & PTE_P) || !(pde & PTE_W) || (pde & PTE_PS))
+    return -1;
+  pte = walkpgdir(pgdir, (char*)va, 0);
+  if(!(*pte & PTE_P) || (*pte & (PTE_U|PTE_W)) != (PTE_U|PTE_W) || (*pte & PTE_SHARED))
+    return 0;
+  if(get_refc(PTE_ADDR(*pte)) != 1)
+    return 0;
+  if(*pte & PTE_A){
+    *pte &= ~PTE_A;
+    return 1;
+  }
+  return 2;
+}
+
+// va의 PTE가 swap slot을 가리키도록 바꾸고, 기존 page의 kernel 주소를 반환
+// (page는 호출한 쪽에서 swap에 write한 뒤 free)
+char*
+swap_unmap(pde_t *pgdir, uint va, uint slot)
+{
+  pte_t *pte = walkpgdir(pgdir, (char*)va, 0);
+  char *mem = P2V(PTE_ADDR(*pte));
+
+  *pte = (slot << PTXSHIFT) | PTE_SWAP;
+  return mem;
+}
+
+// kernel이 inode lock이나 buffer를 잡은 상태로 user memory [uva, uva+n)에 접근하기 전에 호출
+// 아직 읽어오지 않은 program page는 page fault에서 program file의 lock을 잡아야 하므로,
+// lock을 잡기 전에 미리 읽어 page fault가 발생하지 않도록 함 (같은 file이거나 서로 다른 순서로 lock을 잡으면 deadlock)
+void
+touchuva(char *uva, int n)
+{
+  char *a;
+
+  if(n <= 0)
+    return;
+  for(a = (char*)PGROUNDDOWN((uint)uva); a < uva + n; a += PGSIZE)
+    (void)*(volatile char*)a;
+}
+
 //PAGEBREAK!
 // Map user virtual address to kernel address.
 char*
@@ -364,8 +630,10 @@ uva2ka(pde_t *pgdir, char *uva)
 {
   pte_t *pte;
 
+  if(pgdir[PDX(uva)] & PTE_PS) // 4MB hugepage 안의 page
+    return (char*)P2V(PTE_ADDR(pgdir[PDX(uva)])) + ((uint)uva & (HUGEPGSIZE-1));
   pte = walkpgdir(pgdir, uva, 0);
-  if((*pte & PTE_P) == 0)
+  if(pte == 0 || (*pte & PTE_P) == 0)
     return 0;
   if((*pte & PTE_U) == 0)
     return 0;
@@ -398,97 +666,287 @@ copyout(pde_t *pgdir, uint va, void *p, uint len)
   return 0;
 }
 
-void 
-CoW_handler(void)
+// sbrk나 bss로 늘어난 주소 공간에 처음 접근했을 때 page를 mapping
+// read인 경우 zero page를 read-only로 공유하고, write인 경우 0으로 초기화된 page를 할당
+static int
+lazy_handler(pde_t *pgdir, uint va, int write)
 {
-  uint va = rcr2(); // page fault가 발생한 가상 주소를 저장 (CR2 레지스터에 저장되어 있음)
-  if(va >= KERNBASE){ // page fault가 발생한 가상 주소가 잘못된 범위에 속해 있는지 확인 (uint는 unsigned 이므로 < 0 인 경우도 >= KERNBASE  조건으로 확인 가능)
-    panic("invalid virtual address");
-  }
+  char *mem;
 
-  pte_t *pte;
+  if(!write){
+    // 처음 write할 때 CoW_handler에서 새로운 page로 복사됨
+    if(mappages(pgdir, (char*)PGROUNDDOWN(va), PGSIZE, V2P(zeropage), PTE_U) < 0){
+      cprintf("lazy_handler: out of memory (2)\n");
+      return -1;
+    }
+    incr_refc(V2P(zeropage));
+    return 0;
+  }
 
-  if((pte = walkpgdir(myproc()->pgdir, (void*)va, 0)) == 0){ // page fault가 발생한 가상 주소에 대한 page table entry를 pte에 저장
-      panic("address should exist");
+  if(overlimit(acctproc(pgdir), 1)){
+    cprintf("lazy_handler: memory limit exceeded\n");
+    return -1;
   }
+  if((mem = kalloc_user(1)) == 0){
+    cprintf("lazy_handler: out of memory\n");
+    return -1;
+  }
+  if(mappages(pgdir, (char*)PGROUNDDOWN(va), PGSIZE, V2P(mem), PTE_W|PTE_U) < 0){
+    cprintf("lazy_handler: out of memory (2)\n");
+    kfree(mem);
+    return -1;
+  }
+  // present가 아니던 PTE는 TLB에 남아있지 않으므로 TLB flush가 필요 X
+  return 0;
+}
 
+// CoW로 공유 중인 page를 혼자 사용하도록 만듦 (TLB 무효화는 호출한 쪽에서 처리)
+// 새로운 page를 할당하지 못하면 -1을 반환
+// reclaim이 0이면 free page가 없을 때 swap out으로 확보하지 않음 (fault-around에서 미리 복사하는 경우)
+static int
+CoW_copy(pte_t *pte, int reclaim)
+{
   uint pa = PTE_ADDR(*pte); // pte에서 physical page number를 저장
 
-  if(get_refc(pa) > 1){ // 참조 횟수가 1보다 큰 경우(처음 (N-1)개의 process에서 page fault 발생)
+  // 참조 횟수는 한 번만 읽음
+  // 참조 횟수가 1이면 이 page를 참조하는 process가 자신밖에 없으므로, 다른 process가 이 값을 증가시킬 수 없음
+  if(get_refc(pa) == 1){ // 참조 횟수가 1인 경우(마지막 process)
+    *pte = *pte | PTE_W; // page fault가 발생한 page table entry를 공유하지 않고 혼자 사용하기 때문에, Writeable flag만 다시 1으로 설정
+  }
+
+  else{ // 참조 횟수가 1보다 큰 경우(처음 (N-1)개의 process에서 page fault 발생)
     // 기존 copyuvm() 루틴과 동일하게 새로운 page를 할당하여 기존 page를 복사하는 과정 진행
     char *mem;
-    if((mem = kalloc()) == 0){ // 새로운 page를 mem에 할당
-      panic("fail in kalloc");
-    }
+    // 새로운 page를 mem에 할당하며, zero page는 복사하지 않고 0으로 채워진 page를 할당
+    int zero = (pa == V2P(zeropage));
+    if((mem = reclaim ? kalloc_user(zero) : zero ? kalloc_zeroed(PG_USER) : kalloc_type(PG_USER)) == 0)
+      return -1;
 
-    memmove(mem, (char*)P2V(pa), PGSIZE); // 할당한 page(mem)에 기존에 공유하던 page를 복사하여 mapping시킴
+    if(!zero)
+      memmove(mem, (char*)P2V(pa), PGSIZE); // 할당한 page(mem)에 기존에 공유하던 page를 복사하여 mapping시킴
     
     // memset(pte, 0, PGSIZE); // page의 복사본을 가져오므로 초기화할 필요 X
     *pte = V2P(mem) | PTE_P | PTE_W | PTE_U; 
     // page table entry를 새로 할당받고 복사한 mem으로 update하고, flag를 설정
     // walkpgdir의 flag 설정을 참고(새로운 page를 할당하기 때문에)
-    decr_refc(pa); // 기존에 공유하던 page를 더이상 사용하지 않기 때문에 page 참조 횟수 감소
-  }
-  
-  else if(get_refc(pa) == 1){ // 참조 횟수가 1인 경우(마지막 process)
-    *pte = *pte | PTE_W; // page fault가 발생한 page table entry를 공유하지 않고 혼자 사용하기 때문에, Writeable flag만 다시 1으로 설정
+    kfree((char*)P2V(pa)); // 기존에 공유하던 page의 참조 횟수 감소
+    // 다른 process들이 동시에 복사하여 먼저 참조를 놓았다면 이 process가 마지막 참조이므로 kfree에서 page가 free됨
   }
-  lcr3(V2P(myproc()->pgdir)); // page table entry 변경으로 인해, TLB flush 후 CR3 레지스터 값 업데이트
+  return 0;
 }
 
-int
-countvp(void)
+// CoW fault가 직전 fault-around 범위의 바로 다음 page에서 발생하면 순차적으로 write하는 것으로 보고,
+// fault-around 범위를 2배씩 늘려(최대 COWAROUND page) 뒤따르는 CoW page들을 한 번의 fault에서 미리 복사
+// 순차적이지 않은 fault가 발생하면 다시 1 page만 복사
+#define COWAROUND 16
+
+volatile uint cowaround;  // fault-around으로 미리 처리하여 발생하지 않은 CoW fault 수
+
+static int
+CoW_handler(struct proc *p, pte_t *pte, uint va)
 {
-  int count = 0;
-  pte_t *pte;
+  uint a;
+  int n;
 
-  for(uint va = 0; va < myproc()->sz; va += PGSIZE){  
-    // 전체 virtual address 공간(KERNBASE)가 아닌 process가 현재 사용하는 virtual address 까지만 순회하기 위해 myproc()->sz 까지만 순회
-    if((pte = walkpgdir(myproc()->pgdir, (void *)va, 0)) == 0)
-      continue;
-    count++;
+  va = PGROUNDDOWN(va);
+  if(va == p->cownext && p->cowwin < COWAROUND)
+    p->cowwin = p->cowwin ? p->cowwin * 2 : 1;
+  else if(va != p->cownext)
+    p->cowwin = 1;
+
+  if(overlimit(p, 1)){ // 혼자 사용하는 page가 늘어나므로 memory limit을 넘으면 process를 kill
+    cprintf("CoW_handler: memory limit exceeded\n");
+    return -1;
+  }
+  if(CoW_copy(pte, 1) < 0){ // swap out으로도 page를 확보하지 못하면 process를 kill
+    cprintf("CoW_handler: out of memory\n");
+    return -1;
   }
+  xadd(&p->cowpg, -1);
+  invlpg((void*)va); // page table entry 변경으로 인해, 변경된 page만 TLB에서 무효화
+
+  // 같은 page table 안에서 이어지는 CoW page만 미리 처리하고, CoW page가 아니거나 메모리가 부족하면 중단
+  for(n = 1, a = va + PGSIZE; n < p->cowwin && a < p->sz && PDX(a) == PDX(va); n++, a += PGSIZE){
+    pte++;
+    if(!(*pte & PTE_P) || !(*pte & PTE_U) || (*pte & (PTE_W|PTE_SHARED)))
+      break;
+    if(overlimit(p, 1) || CoW_copy(pte, 0) < 0)
+      break;
+    xadd(&p->cowpg, -1);
+    invlpg((void*)a);
+  }
+  if(n > 1)
+    xadd(&cowaround, n - 1);
+  p->cownext = va + n*PGSIZE;
+  return 0;
+}
+
+// va가 속한 4MB hugepage mapping을 같은 physical page를 가리키는 4KB page table로 나눔
+// fork로 공유하거나 일부만 해제하는 것처럼 4KB 단위로 다뤄야 할 때 호출하며, 메모리가 부족하면 -1을 반환
+// (TLB 무효화는 호출한 쪽에서 처리)
+static int
+hugepage_split(pde_t *pgdir, uint va)
+{
+  pde_t *pde;
+  pte_t *pgtab;
+  struct proc *p;
+  uint pa;
+  int i;
 
-  return count;
+  pde = &pgdir[PDX(va)];
+  if(!(*pde & PTE_PS))
+    return 0;
+  if((pgtab = (pte_t*)kalloc_type(PG_PGTAB)) == 0)
+    return -1;
+  if((p = acctproc(pgdir)) != 0)
+    xadd(&p->ptpg, 1);
+  pa = PTE_ADDR(*pde);
+  ksplit_huge(P2V(pa));
+  for(i = 0; i < NPTENTRIES; i++)
+    pgtab[i] = (pa + i*PGSIZE) | PTE_P | PTE_W | PTE_U;
+  *pde = V2P(pgtab) | PTE_P | PTE_W | PTE_U;
+  return 0;
+}
+
+// hugepage를 사용하는 process가 아직 page table이 없는 4MB 영역에 처음 접근했을 때,
+// 그 영역 전체가 process 크기 안에 있으면 4MB page 하나로 mapping (TLB entry 하나로 4MB를 접근)
+// 사용할 수 없으면 -1을 반환하고 4KB page로 처리
+static int
+hugepage_handler(struct proc *p, uint va)
+{
+  uint base = va & ~(HUGEPGSIZE-1);
+  char *mem;
+
+  if(!p->hugepage || (p->pgdir[PDX(va)] & PTE_P) || base + HUGEPGSIZE > p->sz)
+    return -1;
+  if(overlimit(p, NPTENTRIES) || (mem = kalloc_huge()) == 0)
+    return -1;
+  memset(mem, 0, HUGEPGSIZE);
+  p->pgdir[PDX(va)] = V2P(mem) | PTE_P | PTE_W | PTE_U | PTE_PS;
+  xadd(&p->rss, NPTENTRIES);
+  if(p->rss > p->maxrss)
+    p->maxrss = p->rss;
+  return 0;
+}
+
+// swap out된 page에 접근한 경우 새로운 page에 swap slot의 내용을 읽어와 다시 mapping
+static int
+swapin_handler(struct proc *p, pte_t *pte, uint va)
+{
+  uint slot = PTE_ADDR(*pte) >> PTXSHIFT;
+  char *mem;
 
-  // uint va_range = PGROUNDUP(myproc()->sz);
-  // return (va_range / PGSIZE);
+  if((mem = kalloc_user(0)) == 0){
+    cprintf("swapin_handler: out of memory\n");
+    return -1;
+  }
+  swap_read(slot, mem);
+  // swap out할 때 writable page만 골랐으므로 그대로 writable로 mapping
+  // present가 아니던 PTE는 TLB에 남아있지 않으므로 TLB flush가 필요 X
+  *pte = V2P(mem) | PTE_P | PTE_W | PTE_U;
+  acctpte(p, p->pgdir[PDX(va)], *pte, 1);
+  swap_free(slot);
+  return 0;
 }
 
+// Page fault handler.
+// 처리에 성공하면 0, 잘못된 접근이라 처리할 수 없으면 -1을 반환
 int
-countpp(void)
+pgfault_handler(uint err)
 {
-  int count = 0;
+  struct proc *curproc = myproc();
+  uint va = rcr2(); // page fault가 발생한 가상 주소를 저장 (CR2 레지스터에 저장되어 있음)
   pte_t *pte;
+  int unshared = 0;
 
-  for(uint va = 0; va < myproc()->sz; va += PGSIZE){  
-    // 전체 virtual address 공간(KERNBASE)가 아닌 process가 현재 사용하는 virtual address 까지만 순회하기 위해 myproc()->sz 까지만 순회
-    if((pte = walkpgdir(myproc()->pgdir, (void *)va, 0)) == 0)
-      continue;
-    if(!(*pte & PTE_P))
-      continue;
-    count++;
+  if(curproc == 0 || va >= KERNBASE) // page fault가 발생한 가상 주소가 잘못된 범위에 속해 있는지 확인
+    return -1;
+  if(curproc->pgdir[PDX(va)] & PTE_PS) // hugepage는 항상 writable로 mapping되므로 처리할 fault가 없음
+    return -1;
+
+  // fork 이후 공유 중인 page table이면 PTE를 변경하기 전에 먼저 page table을 복사
+  if((curproc->pgdir[PDX(va)] & PTE_P) && !(curproc->pgdir[PDX(va)] & PTE_W)){
+    if(pgtab_unshare(curproc->pgdir, va) < 0){
+      cprintf("pgfault_handler: out of memory\n");
+      return -1;
+    }
+    lcr3(V2P(curproc->pgdir)); // PDE가 변경되었으므로 4MB 영역 전체의 TLB entry를 무효화
+    unshared = 1;
+  }
+
+  pte = walkpgdir(curproc->pgdir, (void*)va, 0);
+  if(pte != 0 && !(*pte & PTE_P) && (*pte & PTE_SWAP)) // swap out된 page
+    return swapin_handler(curproc, pte, va);
+  if(pte == 0 || !(*pte & PTE_P)){ // 아직 mapping되지 않은 page
+    if(va >= curproc->sz) // heap 밖이면 mmap 영역인지 확인
+      return vma_fault(curproc, va, err & FEC_WR);
+    if(inexecseg(curproc, va)) // exec에서 아직 file에서 읽어오지 않은 program page
+      return exec_fault(curproc, va, err & FEC_WR);
+    if(hugepage_handler(curproc, va) == 0)
+      return 0;
+    return lazy_handler(curproc->pgdir, va, err & FEC_WR);
+  }
+
+  if((err & FEC_U) && !(*pte & PTE_U)) // user가 guard page에 접근한 경우
+    return -1;
+  if((err & FEC_WR) && !(*pte & PTE_W)){ // CoW로 공유 중인 page에 write한 경우
+    if(va >= curproc->sz && !(vma_prot(curproc, va) & PROT_WRITE)) // PROT_WRITE가 없는 mmap 영역
+      return -1;
+    return CoW_handler(curproc, pte, va);
   }
+  if(unshared) // page table을 혼자 사용하게 되어 PDE가 writable이 되었으므로 다시 접근하면 됨
+    return 0;
+
+  return -1;
+}
 
-  return count;
+int
+countvp(void)
+{
+  // sbrk로 늘어난 page는 처음 접근하기 전까지 page table entry가 없을 수 있으므로,
+  // page table을 순회하지 않고 process가 현재 사용하는 virtual address 범위(myproc()->sz)로 계산
+  uint va_range = PGROUNDUP(myproc()->sz);
+  return (va_range / PGSIZE);
+}
+
+int
+countpp(void)
+{
+  // page table을 순회하지 않고 mapping할 때마다 갱신하는 counter를 반환 (mmap 영역의 page도 포함)
+  return myproc()->rss;
 }
 
 int
 countptp(void)
 {
-  int count = 0;
-  pde_t *pgdir = myproc()->pgdir;
+  return myproc()->ptpg; // page directory에 사용된 페이지도 count
+}
 
-  if(*pgdir & PTE_P){
-    count++;  // page directory에 사용된 페이지도 count
-    for(int i = 0; i < NPDENTRIES; i++){
-      if(pgdir[i] & PTE_P){
-        count++;
-      }
+// p의 page table을 순회하여 memory counter를 처음부터 다시 계산
+// exec, spawn, userinit에서 새로 만든 page table을 process에 설치한 뒤 호출 (memlimit, maxrss는 유지)
+void
+vmacct(struct proc *p)
+{
+  pde_t *pgdir = p->pgdir;
+  pte_t *pgtab;
+  int i, j;
+
+  p->rss = p->cowpg = p->shmpg = 0;
+  p->ptpg = 1; // page directory
+  for(i = 0; i < NPDENTRIES; i++){
+    if(!(pgdir[i] & PTE_P))
+      continue;
+    if(pgdir[i] & PTE_PS){ // 4MB hugepage에는 page table이 없음
+      acctpte(p, PTE_W, PTE_P | PTE_W, NPTENTRIES);
+      continue;
     }
+    p->ptpg++;
+    if(i >= PDX(KERNBASE))
+      continue;
+    pgtab = (pte_t*)P2V(PTE_ADDR(pgdir[i]));
+    for(j = 0; j < NPTENTRIES; j++)
+      acctpte(p, pgdir[i], pgtab[j], 1);
   }
-
-  return count;
 }
 
 //PAGEBREAK!
@@ -0,0 +1,38 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define PGSIZE  4096
+#define NPAGES  1024            // sparse array 크기 (4MB)
+#define STRIDE  64              // STRIDE page마다 1 page씩만 write
+
+int sparse[NPAGES * PGSIZE / sizeof(int)];  // bss에 위치하므로 처음 접근할 때 mapping됨
+
+int
+main(int argc, char *argv[])
+{
+  int fp, pp, sum = 0;
+  int step = PGSIZE / sizeof(int);
+
+  printf(1, "[zero page bench] sparse array of %d pages\n", NPAGES);
+
+  fp = countfp();
+  pp = countpp();
+
+  // 모든 page를 read하면 zero page 하나만 공유하여 mapping됨
+  for(int i = 0; i < NPAGES; i++)
+    sum += sparse[i * step];
+  printf(1, "read all:   resident pages +%d, free pages -%d\n", countpp() - pp, fp - countfp());
+
+  // 일부 page에만 write하면 write한 page만 새로운 page로 복사됨
+  for(int i = 0; i < NPAGES; i += STRIDE)
+    sparse[i * step] = i;
+  printf(1, "write 1/%d: resident pages +%d, free pages -%d\n", STRIDE, countpp() - pp, fp - countfp());
+
+  if(sum != 0 || sparse[STRIDE * step] != STRIDE || sparse[step] != 0)
+    printf(1, "[zero page bench] fail\n");
+  else
+    printf(1, "[zero page bench] done\n");
+
+  exit();
+}